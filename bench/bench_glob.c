@@ -0,0 +1,101 @@
+/* ============================================================
+ *  bench_glob.c - Parcours récursif "**" selon le nombre de threads
+ *
+ *  Construit sous /tmp une arborescence de D répertoires (sur deux niveaux)
+ *  de F fichiers chacun, puis chronomètre glob_expand("** /f1*.c", sans
+ *  l'espace) avec 1, 2, 4 puis 8 threads, et vérifie que le résultat
+ *  ne dépend pas du nombre de threads.
+ *  Usage : bin/bench_glob [D] [F]   (D = 400, F = 250 par defaut)
+ *  Sortie : une ligne JSON par nombre de threads.
+ * ============================================================ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include "globexp.h"
+
+static double now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static void build_tree(const char *root, int dirs, int files)
+{
+    char path[512];
+
+    mkdir(root, 0755);
+    for (int d = 0; d < dirs; d++) {
+        snprintf(path, sizeof(path), "%s/g%d", root, d % 20);
+        mkdir(path, 0755);
+        snprintf(path, sizeof(path), "%s/g%d/d%d", root, d % 20, d);
+        mkdir(path, 0755);
+        for (int f = 0; f < files; f++) {
+            snprintf(path, sizeof(path), "%s/g%d/d%d/f%d.%s", root, d % 20, d, f,
+                     f % 3 ? "c" : "h");
+            int fd = open(path, O_CREAT | O_WRONLY | O_CLOEXEC, 0644);
+            if (fd >= 0)
+                close(fd);
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int dirs = argc > 1 ? atoi(argv[1]) : 400;
+    int files = argc > 2 ? atoi(argv[2]) : 250;
+    char root[] = "/tmp/msh_bench_glob_XXXXXX";
+    static const int threads[] = {1, 2, 4, 8};
+    char **ref = NULL;
+    int ref_n = -1;
+
+    if (dirs <= 0 || files <= 0 || mkdtemp(root) == NULL) {
+        fprintf(stderr, "usage : %s [D] [F]\n", argv[0]);
+        return 1;
+    }
+    build_tree(root, dirs, files);
+    if (chdir(root) != 0)
+        return 1;
+
+    for (size_t t = 0; t < sizeof(threads) / sizeof(threads[0]); t++) {
+        char **matches;
+        int n;
+        glob_set_threads(threads[t]);
+        double start = now_ms();
+        if (glob_expand("**/f1*.c", &matches, &n) != 0) {
+            fprintf(stderr, "glob_expand a echoue\n");
+            return 1;
+        }
+        double total = now_ms() - start;
+
+        int same = 1;
+        if (ref_n < 0) {
+            ref = matches;
+            ref_n = n;
+        } else {
+            same = n == ref_n;
+            for (int i = 0; same && i < n; i++)
+                same = strcmp(matches[i], ref[i]) == 0;
+            for (int i = 0; i < n; i++)
+                free(matches[i]);
+            free(matches);
+        }
+        printf("{\"bench\":\"glob_recursive\",\"threads\":%d,\"dirs\":%d,\"files\":%d,"
+               "\"matched\":%d,\"same_order\":%s,\"total_ms\":%.2f}\n",
+               threads[t], dirs, dirs * files, n, same ? "true" : "false", total);
+    }
+    for (int i = 0; i < ref_n; i++)
+        free(ref[i]);
+    free(ref);
+
+    char cmd[128];
+    snprintf(cmd, sizeof(cmd), "rm -rf %s", root);
+    if (chdir("/") != 0 || system(cmd) != 0)
+        return 1;
+    return 0;
+}
@@ -0,0 +1,94 @@
+/* ============================================================
+ *  bench_jobs.c - Operations sur la table des jobs
+ *
+ *  Ajoute N jobs fictifs de P processus chacun, puis chronometre les
+ *  recherches par pid et par numero, et le retrait dans un ordre
+ *  aleatoire. Aucun processus n'est cree.
+ *  Usage : bin/bench_jobs [N] [P]   (N = 10000, P = 4 par defaut)
+ *  Sortie : une ligne JSON par operation.
+ * ============================================================ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "shell.h"
+
+static double now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static void report(const char *op, long count, double ms)
+{
+    printf("{\"bench\":\"jobs\",\"op\":\"%s\",\"count\":%ld,\"total_ms\":%.2f,"
+           "\"per_op_ns\":%.0f}\n", op, count, ms, ms * 1e6 / count);
+}
+
+int main(int argc, char **argv)
+{
+    int n = argc > 1 ? atoi(argv[1]) : 10000;
+    int procs = argc > 2 ? atoi(argv[2]) : 4;
+    pid_t *pids;
+    job_t **jobs;
+    long lookups = 0;
+    double t0;
+
+    if (n <= 0 || procs <= 0) {
+        fprintf(stderr, "usage : %s [N] [P]\n", argv[0]);
+        return 1;
+    }
+    pids = malloc(procs * sizeof(pid_t));
+    jobs = malloc(n * sizeof(job_t *));
+    if (!pids || !jobs)
+        return 1;
+    srand(42);
+    init_jobs();
+
+    /* Pids fictifs, distincts, au-dela des pids reels */
+    t0 = now_ms();
+    for (int i = 0; i < n; i++) {
+        for (int k = 0; k < procs; k++)
+            pids[k] = 10000000 + i * procs + k;
+        if (add_job(pids[0], pids, procs, JOB_RUNNING, 1, "sleep 100 | cat") < 0)
+            return 1;
+    }
+    report("add", n, now_ms() - t0);
+
+    t0 = now_ms();
+    for (int r = 0; r < 10; r++) {
+        for (int i = 0; i < n; i++) {
+            pid_t pid = 10000000 + (rand() % n) * procs + rand() % procs;
+            if (find_job_by_pid(pid) == NULL)
+                return 1;
+            lookups++;
+        }
+    }
+    report("find_by_pid", lookups, now_ms() - t0);
+
+    t0 = now_ms();
+    for (int i = 0; i < n; i++) {
+        jobs[i] = find_job_by_id(i + 1);
+        if (jobs[i] == NULL)
+            return 1;
+    }
+    report("find_by_id", n, now_ms() - t0);
+
+    /* Retrait dans un ordre aleatoire */
+    for (int i = n - 1; i > 0; i--) {
+        int k = rand() % (i + 1);
+        job_t *tmp = jobs[i];
+        jobs[i] = jobs[k];
+        jobs[k] = tmp;
+    }
+    t0 = now_ms();
+    for (int i = 0; i < n; i++)
+        remove_job(jobs[i]);
+    report("remove", n, now_ms() - t0);
+
+    free(jobs);
+    free(pids);
+    return num_jobs != 0;
+}
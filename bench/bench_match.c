@@ -0,0 +1,221 @@
+/* ============================================================
+ *  bench_match.c - Motifs glob adverses contre 100k noms
+ *
+ *  Genere N noms (100000 par defaut), dont une partie faite de longues
+ *  suites de 'a' qui font exploser un moteur a retour arriere, puis
+ *  chronometre match_pattern() pour chaque motif. Cree ensuite sous /tmp
+ *  des repertoires synthetiques de F fichiers et chronometre list_dir(),
+ *  a froid (cache vide) puis a chaud.
+ *  Usage : bin/bench_match [N] [F]   (F = 10000 par defaut)
+ *  Sortie : une ligne JSON par motif et par repertoire.
+ * ============================================================ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include "match.h"
+#include "dircache.h"
+#include "dirscan.h"
+
+static const char *patterns[] = {
+    "*.c",
+    "a*",
+    "*a*a*a*a*b",
+    "*a*a*a*a*a*a*a*a*a*a*a*a*b",
+    "a?*[a-c]*a?*[!a]*z",
+    "*[ab][ab][ab][ab][ab][ab]x*",
+    "*?*?*?*?*?*?*?*?*?*?*?*?*?*?*?*?*?*?*?*?*?*?*?*?*?*?*?*?*?*?*?*?*?*?*?*?*?*?*?*?*?*?*?*?*?*?*?*?*?*?*?*?*?*?*?*?*?*?*?*?*?*?*?*?*?*?*c",
+};
+
+static double now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+/* Copie les entrees non repertoires de dir, telles que les liste le cache
+ * des repertoires (lues directement si le repertoire est trop grand pour
+ * etre mis en cache) : ancienne interface du shell, gardee comme reference */
+static int list_dir(const char *dir, char ***content, int *size)
+{
+    const dir_snapshot_t *snap = dircache_get(dir);
+    scan_result_t scan = {0};
+    char **files;
+    int n;
+
+    *content = NULL;
+    *size = 0;
+    if (snap) {
+        files = snap->files;
+        n = snap->nfiles;
+    } else if (errno == EFBIG &&
+               dir_scan(AT_FDCWD, dir, NULL, SCAN_HIDDEN | SCAN_NO_DIRS, 0, &scan) == 0) {
+        files = scan.names;
+        n = scan.count;
+    } else {
+        return 1;
+    }
+    *content = malloc(sizeof(char *) * (n + 1));
+    for (int i = 0; *content && i < n; i++) {
+        (*content)[i] = strdup(files[i]);
+        if (!(*content)[i]) {
+            for (int j = 0; j < i; j++)
+                free((*content)[j]);
+            free(*content);
+            *content = NULL;
+        }
+    }
+    scan_result_free(&scan);
+    if (!*content)
+        return 1;
+    *size = n;
+    return 0;
+}
+
+/* Noms de candidates qui correspondent au motif, copies */
+static int match_pattern(const char *pattern, char **candidates, int n, char ***selected, int *size)
+{
+    int cap = 0;
+    glob_pattern_t *g = glob_compile(pattern);
+
+    *selected = NULL;
+    *size = 0;
+    if (!g)
+        return 1;
+
+    for (int i = 0; i < n; i++) {
+        if (!glob_match(g, candidates[i], strlen(candidates[i])))
+            continue;
+        if (*size == cap) {
+            cap = cap ? cap * 2 : 16;
+            char **tmp = realloc(*selected, sizeof(char *) * cap);
+            if (!tmp) {
+                for (int j = 0; j < *size; j++)
+                    free((*selected)[j]);
+                free(*selected);
+                *selected = NULL;
+                *size = 0;
+                glob_free(g);
+                return 1;
+            }
+            *selected = tmp;
+        }
+        (*selected)[*size] = strdup(candidates[i]);
+        (*size)++;
+    }
+    glob_free(g);
+    return 0;
+}
+
+static void free_list(char **list, int size)
+{
+    for (int i = 0; i < size; i++)
+        free(list[i]);
+    free(list);
+}
+
+/* list_dir() sur un repertoire de files fichiers (et un sous-repertoire
+ * sur dix, que list_dir ecarte) */
+static int bench_list_dir(int files)
+{
+    char root[] = "/tmp/msh_bench_ls_XXXXXX";
+    char path[512];
+    char **list;
+    int size;
+
+    if (mkdtemp(root) == NULL)
+        return 1;
+    for (int i = 0; i < files; i++) {
+        snprintf(path, sizeof(path), "%s/fichier_%06d.%s", root, i, i % 3 ? "c" : "txt");
+        if (i % 10 == 0) {
+            mkdir(path, 0755);
+            continue;
+        }
+        int fd = open(path, O_CREAT | O_WRONLY | O_CLOEXEC, 0644);
+        if (fd >= 0)
+            close(fd);
+    }
+
+    dircache_clear();
+    double t0 = now_ms();
+    if (list_dir(root, &list, &size) != 0)
+        return 1;
+    double cold = now_ms() - t0;
+    free_list(list, size);
+
+    const int rounds = 20;
+    t0 = now_ms();
+    for (int r = 0; r < rounds; r++) {
+        if (list_dir(root, &list, &size) != 0)
+            return 1;
+        free_list(list, size);
+    }
+    double warm = (now_ms() - t0) / rounds;
+
+    printf("{\"bench\":\"list_dir\",\"entries\":%d,\"files\":%d,"
+           "\"cold_ms\":%.2f,\"warm_ms\":%.2f}\n", files, size, cold, warm);
+
+    snprintf(path, sizeof(path), "rm -rf %s", root);
+    return system(path) != 0;
+}
+
+int main(int argc, char **argv)
+{
+    int n = argc > 1 ? atoi(argv[1]) : 100000;
+    int files = argc > 2 ? atoi(argv[2]) : 10000;
+    char **names = malloc(n * sizeof(char *));
+
+    if (n <= 0 || files <= 0 || !names) {
+        fprintf(stderr, "usage : %s [N] [F]\n", argv[0]);
+        return 1;
+    }
+    srand(42);
+    for (int i = 0; i < n; i++) {
+        int len = 8 + rand() % 120;
+        char *s = malloc(len + 3);
+        if (!s)
+            return 1;
+        if (i % 4 == 0) {
+            /* Cas pire : que des 'a', sans le 'b' final attendu */
+            memset(s, 'a', len);
+        } else {
+            for (int k = 0; k < len; k++)
+                s[k] = "abcxyz_."[rand() % 8];
+        }
+        s[len] = '\0';
+        if (i % 10 == 0)
+            strcpy(s + len, ".c");
+        names[i] = s;
+    }
+
+    for (size_t p = 0; p < sizeof(patterns) / sizeof(patterns[0]); p++) {
+        char **selected;
+        int size;
+        double start = now_ms();
+        if (match_pattern(patterns[p], names, n, &selected, &size) != 0) {
+            fprintf(stderr, "match_pattern a echoue\n");
+            return 1;
+        }
+        double total = now_ms() - start;
+        printf("{\"bench\":\"match_pattern\",\"pattern\":\"%s\",\"names\":%d,"
+               "\"matched\":%d,\"total_ms\":%.2f,\"per_name_ns\":%.0f}\n",
+               patterns[p], n, size, total, total * 1e6 / n);
+        free_list(selected, size);
+    }
+    free_list(names, n);
+
+    /* Petit, moyen, puis gros repertoire */
+    for (int f = files / 100 > 0 ? files / 100 : 1; f <= files; f *= 10) {
+        if (bench_list_dir(f) != 0) {
+            fprintf(stderr, "list_dir a echoue\n");
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,117 @@
+/* ============================================================
+ *  bench_parse.c - Coût de readcmd() par ligne
+ *
+ *  Analyse N lignes typiques (1000000 par defaut) lues dans une chaine,
+ *  et compte les appels a malloc/calloc/realloc faits pendant l'analyse
+ *  (malloc est remplace ici par une enveloppe qui compte). Une fois
+ *  l'arene chaude, une ligne sans glob ne doit faire aucun appel.
+ *  Le script est passe deux fois : sans puis avec le cache des lignes.
+ *  Usage : bin/bench_parse [N]
+ *  Sortie : une ligne JSON par passe, puis le gain du cache.
+ * ============================================================ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "readcmd.h"
+#include "input.h"
+
+static const char *lines[] = {
+    "ls -l /tmp",
+    "cat < in.txt | grep -v foo | sort -r > out.txt",
+    "echo un deux trois quatre cinq six sept huit neuf dix",
+    "sleep 1 &",
+    "make -j8 all >> build.log",
+    "cd ~/src",
+};
+#define NLINES (sizeof(lines) / sizeof(lines[0]))
+
+/* ========== Comptage des appels au tas ========== */
+
+extern void *__libc_malloc(size_t);
+extern void *__libc_calloc(size_t, size_t);
+extern void *__libc_realloc(void *, size_t);
+extern void __libc_free(void *);
+
+static unsigned long heap_calls = 0;
+
+void *malloc(size_t n) { heap_calls++; return __libc_malloc(n); }
+void *calloc(size_t n, size_t m) { heap_calls++; return __libc_calloc(n, m); }
+void *realloc(void *p, size_t n) { heap_calls++; return __libc_realloc(p, n); }
+void free(void *p) { __libc_free(p); }
+
+static double now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+/* Analyse tout le script ; retourne la duree en ms hors echauffement */
+static double run(const char *text, long n, int cache, long *parsed, unsigned long *warm)
+{
+    struct cmdline *l;
+
+    readcmd_set_cache(cache);
+    input_set_string(text);
+
+    /* Premier tour : l'arene et le cache atteignent leur taille de croisiere */
+    for (size_t i = 0; i < NLINES; i++)
+        readcmd();
+
+    unsigned long before = heap_calls;
+    *parsed = NLINES;
+    double t0 = now_ms();
+    while (*parsed < n && (l = readcmd()) != NULL) {
+        if (l->err)
+            fprintf(stderr, "erreur : %s\n", l->err);
+        (*parsed)++;
+    }
+    double t1 = now_ms();
+    *warm = heap_calls - before;
+    return t1 - t0;
+}
+
+int main(int argc, char **argv)
+{
+    long n = argc > 1 ? atol(argv[1]) : 1000000;
+    size_t size = 0, used = 0;
+    struct readcmd_stats st;
+    unsigned long warm[2];
+    double ms[2];
+    long parsed;
+    char *text;
+
+    if (n <= (long)NLINES) {
+        fprintf(stderr, "usage : %s [N]\n", argv[0]);
+        return 1;
+    }
+    for (size_t i = 0; i < NLINES; i++)
+        size += strlen(lines[i]) + 1;
+    size = size * (n / NLINES + 1) + 1;
+    text = malloc(size);
+    if (!text)
+        return 1;
+    for (long i = 0; i < n; i++) {
+        const char *s = lines[i % NLINES];
+        size_t len = strlen(s);
+        memcpy(text + used, s, len);
+        text[used + len] = '\n';
+        used += len + 1;
+    }
+    text[used] = '\0';
+
+    for (int cache = 0; cache <= 1; cache++) {
+        ms[cache] = run(text, n, cache, &parsed, &warm[cache]);
+        readcmd_get_stats(&st);
+        printf("{\"bench\":\"parse\",\"linecache\":%s,\"lines\":%ld,\"ms\":%.2f,"
+               "\"ns_per_line\":%.1f,\"heap_calls_warm\":%lu,\"cache_hits\":%lu,"
+               "\"cache_misses\":%lu,\"arena_bytes\":%zu}\n",
+               cache ? "true" : "false", parsed, ms[cache],
+               ms[cache] * 1e6 / (parsed - NLINES), warm[cache],
+               st.cache_hits, st.cache_misses, st.arena_bytes);
+    }
+    printf("{\"bench\":\"parse_linecache_speedup\",\"speedup\":%.2f}\n", ms[0] / ms[1]);
+    return warm[0] != 0 || warm[1] != 0;
+}
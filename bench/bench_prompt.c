@@ -0,0 +1,125 @@
+/* ============================================================
+ *  bench_prompt.c - Aller-retour jusqu'au prompt
+ *
+ *  Lance le shell relie a deux tubes, puis N fois : envoie une commande
+ *  et attend que le prompt suivant soit affiche. Mesure la commande
+ *  integree "true" (sans fork) puis /bin/true (fork + exec + attente).
+ *  Usage : bin/bench_prompt [N] [shell]   (N = 2000, shell = bin/shell)
+ *  Sortie : une ligne JSON par commande.
+ * ============================================================ */
+
+#define _GNU_SOURCE // memmem
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/wait.h>
+
+#define PROMPT "Mini-shell >>> \033[0m"
+
+static int to_shell = -1, from_shell = -1;
+
+static double now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static int cmp_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/* Lit la sortie du shell jusqu'a la fin d'un prompt */
+static int wait_prompt(void)
+{
+    static char buf[4096];
+    static size_t len = 0;
+    const size_t plen = strlen(PROMPT);
+
+    while (1) {
+        char *p = len >= plen ? memmem(buf, len, PROMPT, plen) : NULL;
+        if (p != NULL) {
+            size_t used = p + plen - buf;
+            memmove(buf, buf + used, len - used);
+            len -= used;
+            return 0;
+        }
+        // Garder seulement de quoi reconnaitre un prompt coupe en deux
+        if (len == sizeof(buf)) {
+            memmove(buf, buf + len - plen, plen);
+            len = plen;
+        }
+        ssize_t n = read(from_shell, buf + len, sizeof(buf) - len);
+        if (n <= 0)
+            return -1;
+        len += n;
+    }
+}
+
+static int run(const char *cmd, int n, double *lat)
+{
+    char line[64];
+    int l = snprintf(line, sizeof(line), "%s\n", cmd);
+    double total = 0;
+
+    for (int i = 0; i < n; i++) {
+        double t0 = now_us();
+        if (write(to_shell, line, l) != l || wait_prompt() != 0)
+            return 1;
+        lat[i] = now_us() - t0;
+        total += lat[i];
+    }
+    qsort(lat, n, sizeof(double), cmp_double);
+    printf("{\"bench\":\"prompt_roundtrip\",\"command\":\"%s\",\"iterations\":%d,"
+           "\"mean_us\":%.1f,\"p50_us\":%.1f,\"p99_us\":%.1f}\n",
+           cmd, n, total / n, lat[n / 2], lat[n * 99 / 100]);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    int n = argc > 1 ? atoi(argv[1]) : 2000;
+    const char *shell = argc > 2 ? argv[2] : "bin/shell";
+    double *lat = malloc((n > 0 ? n : 1) * sizeof(double));
+    int in[2], out[2], status;
+    pid_t pid;
+
+    if (n <= 0 || !lat || access(shell, X_OK) != 0) {
+        fprintf(stderr, "usage : %s [N] [shell]\n", argv[0]);
+        return 1;
+    }
+    if (pipe(in) < 0 || pipe(out) < 0)
+        return 1;
+    signal(SIGPIPE, SIG_IGN);
+
+    pid = fork();
+    if (pid == 0) {
+        int null = open("/dev/null", O_WRONLY);
+        dup2(in[0], STDIN_FILENO);
+        dup2(out[1], STDOUT_FILENO);
+        dup2(null, STDERR_FILENO);
+        close(in[0]); close(in[1]); close(out[0]); close(out[1]); close(null);
+        execl(shell, shell, (char *)NULL);
+        _exit(127);
+    }
+    close(in[0]);
+    close(out[1]);
+    to_shell = in[1];
+    from_shell = out[0];
+
+    int err = wait_prompt() != 0 || run("true", n, lat) || run("/bin/true", n, lat);
+    if (write(to_shell, "quit\n", 5) != 5)
+        err = 1;
+    close(to_shell);
+    waitpid(pid, &status, 0);
+    free(lat);
+    if (err)
+        fprintf(stderr, "bench_prompt: pas de prompt du shell\n");
+    return err;
+}
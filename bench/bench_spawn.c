@@ -0,0 +1,100 @@
+/* ============================================================
+ *  bench_spawn.c - Latence de lancement d'un processus
+ *
+ *  Lance N fois /bin/true et attend sa fin, par fork()+execv() puis par
+ *  posix_spawn(), d'abord avec un petit espace memoire puis apres avoir
+ *  touche M Mio de tas (fork copie les tables de pages, pas posix_spawn).
+ *  Usage : bin/bench_spawn [N] [M]   (N = 2000, M = 256 par defaut)
+ *  Sortie : une ligne JSON par methode et par taille memoire.
+ * ============================================================ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <spawn.h>
+#include <sys/wait.h>
+
+extern char **environ;
+
+static char *const true_argv[] = {"/bin/true", NULL};
+
+static double now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static int cmp_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static pid_t spawn_fork(void)
+{
+    pid_t pid = fork();
+    if (pid == 0) {
+        execv(true_argv[0], true_argv);
+        _exit(127);
+    }
+    return pid;
+}
+
+static pid_t spawn_posix(void)
+{
+    pid_t pid;
+    if (posix_spawn(&pid, true_argv[0], NULL, NULL, true_argv, environ) != 0)
+        return -1;
+    return pid;
+}
+
+static int run(const char *method, pid_t (*spawn)(void), int n, int rss_mb, double *lat)
+{
+    double total = 0;
+
+    for (int i = 0; i < n; i++) {
+        int status;
+        double t0 = now_us();
+        pid_t pid = spawn();
+        if (pid < 0 || waitpid(pid, &status, 0) != pid)
+            return 1;
+        lat[i] = now_us() - t0;
+        total += lat[i];
+    }
+    qsort(lat, n, sizeof(double), cmp_double);
+    printf("{\"bench\":\"spawn\",\"method\":\"%s\",\"rss_mb\":%d,\"iterations\":%d,"
+           "\"mean_us\":%.1f,\"p50_us\":%.1f,\"p99_us\":%.1f}\n",
+           method, rss_mb, n, total / n, lat[n / 2], lat[n * 99 / 100]);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    int n = argc > 1 ? atoi(argv[1]) : 2000;
+    int rss_mb = argc > 2 ? atoi(argv[2]) : 256;
+    double *lat = malloc((n > 0 ? n : 1) * sizeof(double));
+
+    if (n <= 0 || rss_mb < 0 || !lat) {
+        fprintf(stderr, "usage : %s [N] [M]\n", argv[0]);
+        return 1;
+    }
+    if (run("fork_exec", spawn_fork, n, 0, lat) || run("posix_spawn", spawn_posix, n, 0, lat))
+        return 1;
+
+    if (rss_mb > 0) {
+        size_t size = (size_t)rss_mb << 20;
+        char *heap = malloc(size);
+        if (!heap)
+            return 1;
+        memset(heap, 1, size);
+        if (run("fork_exec", spawn_fork, n, rss_mb, lat) ||
+            run("posix_spawn", spawn_posix, n, rss_mb, lat))
+            return 1;
+        free(heap);
+    }
+    free(lat);
+    return 0;
+}
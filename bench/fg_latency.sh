@@ -0,0 +1,29 @@
+#!/bin/bash
+# ============================================================
+#  fg_latency.sh - Latence de retour au prompt en premier plan
+#
+#  Envoie N fois une commande triviale au shell et mesure le temps total.
+#  Usage : bench/fg_latency.sh [N] [shell] [commande]
+#          (N = 10000, commande = /bin/true par defaut ; "true" mesure la
+#          commande integree, sans fork ni exec)
+# ============================================================
+
+N=${1:-10000}
+SHELL_BIN=${2:-bin/shell}
+CMD=${3:-/bin/true}
+[ -x "$SHELL_BIN" ] || { echo "$SHELL_BIN introuvable (faire make)" >&2; exit 1; }
+INPUT=$(mktemp /tmp/bench_fg_XXXXXX)
+trap "rm -f $INPUT" EXIT
+
+for ((i = 0; i < N; i++)); do
+    echo "$CMD"
+done > "$INPUT"
+echo "quit" >> "$INPUT"
+
+start=$(date +%s%N)
+"$SHELL_BIN" < "$INPUT" > /dev/null 2>&1
+end=$(date +%s%N)
+
+total_ns=$((end - start))
+printf '{"bench":"fg_latency","command":"%s","iterations":%d,"total_ms":%d,"per_cmd_us":%d}\n' \
+    "$CMD" "$N" $((total_ns / 1000000)) $((total_ns / N / 1000))
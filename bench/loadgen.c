@@ -0,0 +1,451 @@
+/* ============================================================
+ *  loadgen.c - Generateur de charge et tempete de SIGCHLD
+ *
+ *  Pilote le shell par deux tubes, comme un utilisateur tres rapide :
+ *   - mix   : N commandes tirees d'un melange pondere, a un debit cible
+ *             (latence mesuree de l'envoi au prompt suivant) ;
+ *   - storm : B jobs "cat FIFO &" bloques sur le meme tube nomme, liberes
+ *             d'un coup : ils se terminent tous dans la meme milliseconde ;
+ *   - tstp  : Z cycles Ctrl+Z / fg sur une commande externe ;
+ *   - check : la table des jobs doit etre vide, chaque job lance en
+ *             arriere-plan doit avoir ete annonce "Done", et le shell ne
+ *             doit plus avoir d'enfant (ni zombie).
+ *  Usage : bin/loadgen [-s shell] [-n N] [-r debit] [-m melange]
+ *                      [-b B] [-z Z] [-t delai_ms]
+ *          melange : "poids:commande,..." (defaut 60:true,30:/bin/true,10:/bin/true &)
+ *          debit   : commandes par seconde, 0 = au plus vite (defaut)
+ *  Sortie : une ligne JSON par phase ; code de retour 1 si une
+ *           verification echoue.
+ * ============================================================ */
+
+#define _GNU_SOURCE // memmem
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#define PROMPT "Mini-shell >>> \033[0m"
+#define MAX_MIX 16
+
+typedef struct {
+    int weight;
+    char *cmd;
+} mix_entry_t;
+
+static pid_t shell_pid;
+static int to_shell = -1, from_shell = -1;
+static int timeout_ms = 5000;
+
+static char rbuf[1 << 16];          // Sortie du shell pas encore analysee
+static size_t rlen = 0;
+
+// Ce que le shell a annonce
+static long bg_started = 0;         // "[n] pid" apres une commande en arriere-plan
+static long done_seen = 0;          // "[n] Done", ou "[n] pid Done" dans "jobs"
+static long stopped_seen = 0;       // "[n] Stopped"
+static long listed = 0;             // Jobs vivants listes par "jobs" depuis le dernier reset
+static long timeouts = 0;
+
+
+static double now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static int cmp_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static double pct(double *sorted, long n, double p)
+{
+    long i = (long)(n * p);
+    return n > 0 ? sorted[i < n ? i : n - 1] : 0;
+}
+
+/* ========== Lecture de la sortie du shell ========== */
+
+// Classe une ligne de sortie, sequences de couleur retirees
+static void scan_line(const char *p, size_t n)
+{
+    char line[512];
+    size_t l = 0;
+    int id, pid, end = 0;
+
+    for (size_t i = 0; i < n && l < sizeof(line) - 1; i++) {
+        if (p[i] == '\033') {
+            while (i < n && p[i] != 'm') i++;
+            continue;
+        }
+        line[l++] = p[i];
+    }
+    line[l] = '\0';
+    if (line[0] != '[')
+        return;
+
+    if (sscanf(line, "[%d] %d%n", &id, &pid, &end) == 2) {
+        if (line[end] == '\0')
+            bg_started++;     // Lancement en arriere-plan
+        else if (strstr(line + end, "Done") != NULL)
+            done_seen++;      // "jobs" annonce la fin, puis oublie le job
+        else
+            listed++;         // Ligne de "jobs" : "[n] pid Etat cmd"
+    } else if (strstr(line, "Done") != NULL) {
+        done_seen++;
+    } else if (strstr(line, "Stopped") != NULL) {
+        stopped_seen++;
+    }
+}
+
+static void scan_output(const char *p, size_t n)
+{
+    const char *end = p + n;
+
+    while (p < end) {
+        const char *nl = memchr(p, '\n', end - p);
+        if (nl == NULL)
+            nl = end;
+        scan_line(p, nl - p);
+        p = nl + 1;
+    }
+}
+
+/* Attend le prochain prompt en analysant tout ce qui le precede.
+ * Retourne 0, -1 si le shell a ferme sa sortie, -2 apres timeout_ms. */
+static int wait_prompt(void)
+{
+    const size_t plen = strlen(PROMPT);
+    double deadline = now_us() + timeout_ms * 1e3;
+
+    while (1) {
+        char *p = rlen >= plen ? memmem(rbuf, rlen, PROMPT, plen) : NULL;
+        if (p != NULL) {
+            size_t used = p + plen - rbuf;
+            scan_output(rbuf, p - rbuf);
+            memmove(rbuf, rbuf + used, rlen - used);
+            rlen -= used;
+            return 0;
+        }
+        // Tampon plein sans prompt : analyser les lignes completes
+        if (rlen == sizeof(rbuf)) {
+            char *nl = memrchr(rbuf, '\n', rlen);
+            size_t used = nl ? (size_t)(nl + 1 - rbuf) : rlen - plen;
+            scan_output(rbuf, used);
+            memmove(rbuf, rbuf + used, rlen - used);
+            rlen -= used;
+        }
+
+        struct pollfd pfd = { from_shell, POLLIN, 0 };
+        int left = (int)((deadline - now_us()) / 1e3);
+        if (left <= 0 || poll(&pfd, 1, left) == 0) {
+            timeouts++;
+            return -2;
+        }
+        ssize_t n = read(from_shell, rbuf + rlen, sizeof(rbuf) - rlen);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return -1;
+        rlen += n;
+    }
+}
+
+static int send_line(const char *cmd)
+{
+    char line[512];
+    int l = snprintf(line, sizeof(line), "%s\n", cmd);
+    return write(to_shell, line, l) == l ? 0 : -1;
+}
+
+/* Envoie une commande et attend le prompt ; retourne la latence en us */
+static double roundtrip(const char *cmd)
+{
+    double t0 = now_us();
+    if (send_line(cmd) != 0 || wait_prompt() == -1) {
+        fprintf(stderr, "loadgen: le shell ne repond plus\n");
+        exit(1);
+    }
+    return now_us() - t0;
+}
+
+/* ========== Enfants du shell (/proc) ========== */
+
+// Nombre d'enfants du shell, et combien sont des zombies
+static int shell_children(int *zombies)
+{
+    char path[64], buf[8192];
+    int n = 0, fd;
+    ssize_t len;
+
+    *zombies = 0;
+    snprintf(path, sizeof(path), "/proc/%d/task/%d/children", shell_pid, shell_pid);
+    if ((fd = open(path, O_RDONLY)) < 0)
+        return -1;
+    len = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if (len < 0)
+        return -1;
+    buf[len] = '\0';
+
+    for (char *tok = strtok(buf, " \n"); tok != NULL; tok = strtok(NULL, " \n")) {
+        char stat[512], *rp;
+        n++;
+        snprintf(path, sizeof(path), "/proc/%s/stat", tok);
+        if ((fd = open(path, O_RDONLY)) < 0)
+            continue;
+        len = read(fd, stat, sizeof(stat) - 1);
+        close(fd);
+        stat[len > 0 ? len : 0] = '\0';
+        // L'etat suit le nom, entre parentheses
+        if ((rp = strrchr(stat, ')')) != NULL && rp[1] == ' ' && rp[2] == 'Z')
+            (*zombies)++;
+    }
+    return n;
+}
+
+// Attend que le shell ait lance au moins un enfant
+static int wait_child(void)
+{
+    int z;
+    double deadline = now_us() + timeout_ms * 1e3;
+
+    while (shell_children(&z) <= 0) {
+        if (now_us() > deadline)
+            return -1;
+        usleep(200);
+    }
+    return 0;
+}
+
+/* Redemande "jobs" jusqu'a ce que la table soit vide ; retourne la duree
+ * en ms, ou -1 si elle ne se vide pas dans le delai */
+static double drain_jobs(void)
+{
+    double t0 = now_us();
+
+    while (1) {
+        listed = 0;
+        roundtrip("jobs");
+        if (listed == 0)
+            return (now_us() - t0) / 1e3;
+        if (now_us() - t0 > timeout_ms * 1e3)
+            return -1;
+        usleep(1000);
+    }
+}
+
+/* ========== Phases ========== */
+
+static int parse_mix(char *spec, mix_entry_t *mix)
+{
+    int n = 0;
+
+    for (char *tok = strtok(spec, ","); tok != NULL && n < MAX_MIX; tok = strtok(NULL, ",")) {
+        char *colon = strchr(tok, ':');
+        if (colon == NULL || (mix[n].weight = atoi(tok)) <= 0)
+            return -1;
+        mix[n++].cmd = colon + 1;
+    }
+    return n;
+}
+
+static void phase_mix(mix_entry_t *mix, int nmix, long n, double rate)
+{
+    double *lat = malloc(n * sizeof(double));
+    int total = 0;
+
+    if (lat == NULL)
+        exit(1);
+    for (int i = 0; i < nmix; i++)
+        total += mix[i].weight;
+
+    double start = now_us();
+    for (long i = 0; i < n; i++) {
+        int r = rand() % total, k = 0;
+        while (r >= mix[k].weight)
+            r -= mix[k++].weight;
+
+        // Debit cible : la commande i part a start + i / rate
+        if (rate > 0) {
+            double wait = start + i * 1e6 / rate - now_us();
+            if (wait > 0)
+                usleep((useconds_t)wait);
+        }
+        lat[i] = roundtrip(mix[k].cmd);
+    }
+    double elapsed = (now_us() - start) / 1e6;
+
+    qsort(lat, n, sizeof(double), cmp_double);
+    printf("{\"bench\":\"loadgen\",\"phase\":\"mix\",\"commands\":%ld,\"target_rate\":%.0f,"
+           "\"achieved_rate\":%.0f,\"p50_us\":%.1f,\"p99_us\":%.1f,\"p999_us\":%.1f,"
+           "\"max_us\":%.1f}\n", n, rate, n / elapsed, pct(lat, n, 0.5), pct(lat, n, 0.99),
+           pct(lat, n, 0.999), lat[n - 1]);
+    free(lat);
+}
+
+static void phase_storm(int jobs)
+{
+    char dir[] = "/tmp/msh_storm_XXXXXX", fifo[64], cmd[128];
+    long before = done_seen;
+
+    if (mkdtemp(dir) == NULL)
+        exit(1);
+    snprintf(fifo, sizeof(fifo), "%s/fifo", dir);
+    if (mkfifo(fifo, 0600) != 0)
+        exit(1);
+
+    // Chaque cat reste bloque dans open() jusqu'a ce qu'un ecrivain arrive
+    snprintf(cmd, sizeof(cmd), "cat %s &", fifo);
+    for (int i = 0; i < jobs; i++)
+        roundtrip(cmd);
+    usleep(200000);
+
+    // Ouvrir puis fermer le tube : tous les cat voient la fin de fichier ensemble
+    double t0 = now_us();
+    int fd = open(fifo, O_WRONLY);
+    if (fd >= 0)
+        close(fd);
+    double reap = drain_jobs();
+    double total_ms = (now_us() - t0) / 1e3;
+
+    printf("{\"bench\":\"loadgen\",\"phase\":\"storm\",\"jobs\":%d,\"done_seen\":%ld,"
+           "\"reap_ms\":%.2f}\n", jobs, done_seen - before, reap < 0 ? -1 : total_ms);
+    unlink(fifo);
+    rmdir(dir);
+}
+
+static void phase_tstp(int cycles)
+{
+    double *lat = malloc((cycles > 0 ? cycles : 1) * sizeof(double));
+    long before = stopped_seen;
+    int done = 0;
+
+    if (lat == NULL)
+        exit(1);
+    if (send_line("/bin/sleep 60") != 0 || wait_child() != 0) {
+        fprintf(stderr, "loadgen: /bin/sleep n'a pas demarre\n");
+        free(lat);
+        return;
+    }
+    usleep(2000);       // Laisser le shell enregistrer le job
+
+    for (; done < cycles; done++) {
+        double t0 = now_us();
+        kill(shell_pid, SIGTSTP);
+        if (wait_prompt() != 0)
+            break;
+        lat[done] = now_us() - t0;
+        if (send_line("fg") != 0)
+            break;
+        usleep(2000);   // Le job reprend au premier plan
+    }
+    kill(shell_pid, SIGINT);
+    wait_prompt();
+
+    qsort(lat, done, sizeof(double), cmp_double);
+    printf("{\"bench\":\"loadgen\",\"phase\":\"tstp\",\"cycles\":%d,\"stopped_seen\":%ld,"
+           "\"p50_us\":%.1f,\"p99_us\":%.1f,\"max_us\":%.1f}\n", done, stopped_seen - before,
+           pct(lat, done, 0.5), pct(lat, done, 0.99), done ? lat[done - 1] : 0);
+    free(lat);
+}
+
+static int phase_check(void)
+{
+    int zombies, children;
+    double drain = drain_jobs();
+
+    // Les derniers processus peuvent etre en train d'etre recoltes
+    for (int i = 0; i < 100 && (children = shell_children(&zombies)) > 0; i++)
+        usleep(10000);
+
+    long lost = bg_started - done_seen;
+    int ok = drain >= 0 && lost == 0 && children == 0 && zombies == 0 && timeouts == 0;
+    printf("{\"bench\":\"loadgen\",\"phase\":\"check\",\"bg_started\":%ld,\"done_seen\":%ld,"
+           "\"lost\":%ld,\"jobs_left\":%s,\"children_left\":%d,\"zombies\":%d,"
+           "\"timeouts\":%ld,\"ok\":%s}\n", bg_started, done_seen, lost,
+           drain >= 0 ? "false" : "true", children, zombies, timeouts, ok ? "true" : "false");
+    return ok;
+}
+
+/* ========== Programme principal ========== */
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "usage : %s [-s shell] [-n N] [-r debit] [-m melange] "
+            "[-b B] [-z Z] [-t delai_ms]\n", prog);
+    exit(1);
+}
+
+int main(int argc, char **argv)
+{
+    const char *shell = "bin/shell";
+    char default_mix[] = "60:true,30:/bin/true,10:/bin/true &";
+    char *mix_spec = default_mix;
+    mix_entry_t mix[MAX_MIX];
+    long n = 5000;
+    double rate = 0;
+    int storm = 200, cycles = 50, nmix, opt;
+    int in[2], out[2], status;
+
+    while ((opt = getopt(argc, argv, "s:n:r:m:b:z:t:")) != -1) {
+        switch (opt) {
+        case 's': shell = optarg; break;
+        case 'n': n = atol(optarg); break;
+        case 'r': rate = atof(optarg); break;
+        case 'm': mix_spec = optarg; break;
+        case 'b': storm = atoi(optarg); break;
+        case 'z': cycles = atoi(optarg); break;
+        case 't': timeout_ms = atoi(optarg); break;
+        default: usage(argv[0]);
+        }
+    }
+    if ((nmix = parse_mix(mix_spec, mix)) <= 0 || n <= 0 || rate < 0 ||
+        storm < 0 || cycles < 0 || timeout_ms <= 0 || access(shell, X_OK) != 0)
+        usage(argv[0]);
+
+    if (pipe(in) < 0 || pipe(out) < 0)
+        return 1;
+    signal(SIGPIPE, SIG_IGN);
+    srand(42);
+
+    shell_pid = fork();
+    if (shell_pid == 0) {
+        int null = open("/dev/null", O_WRONLY);
+        dup2(in[0], STDIN_FILENO);
+        dup2(out[1], STDOUT_FILENO);
+        dup2(null, STDERR_FILENO);
+        close(in[0]); close(in[1]); close(out[0]); close(out[1]); close(null);
+        execl(shell, shell, (char *)NULL);
+        _exit(127);
+    }
+    close(in[0]);
+    close(out[1]);
+    to_shell = in[1];
+    from_shell = out[0];
+    if (wait_prompt() != 0) {
+        fprintf(stderr, "loadgen: pas de prompt du shell\n");
+        return 1;
+    }
+
+    phase_mix(mix, nmix, n, rate);
+    if (storm > 0)
+        phase_storm(storm);
+    if (cycles > 0)
+        phase_tstp(cycles);
+    int ok = phase_check();
+
+    send_line("quit");
+    close(to_shell);
+    waitpid(shell_pid, &status, 0);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,35 @@
+#!/bin/bash
+# ============================================================
+#  pipeline_bw.sh - Debit d'un pipeline de N etapes
+#
+#  Fait traverser MO Mio de zeros a "head | cat | ... | wc -c" dans le
+#  shell, pour 2, 4, 8 et 16 etapes, et en deduit le debit.
+#  Usage : bench/pipeline_bw.sh [MO] [shell]   (MO = 256 par defaut)
+# ============================================================
+
+MB=${1:-256}
+SHELL_BIN=${2:-bin/shell}
+
+[ -x "$SHELL_BIN" ] || { echo "$SHELL_BIN introuvable (faire make)" >&2; exit 1; }
+OUTPUT=$(mktemp /tmp/bench_bw_out_XXXXXX)
+trap "rm -f $OUTPUT" EXIT
+
+for N in 2 4 8 16; do
+    CMD="head -c ${MB}M /dev/zero"
+    for ((i = 2; i < N; i++)); do
+        CMD="$CMD | cat"
+    done
+    CMD="$CMD | wc -c > $OUTPUT"
+
+    start=$(date +%s%N)
+    "$SHELL_BIN" -c "$CMD" > /dev/null 2>&1
+    end=$(date +%s%N)
+
+    if [ "$(cat "$OUTPUT")" != "$((MB * 1024 * 1024))" ]; then
+        echo "pipeline_bw: sortie incorrecte" >&2
+        exit 1
+    fi
+    total_ns=$((end - start))
+    printf '{"bench":"pipeline_bw","stages":%d,"mbytes":%d,"total_ms":%d,"mb_per_s":%d}\n' \
+        "$N" "$MB" $((total_ns / 1000000)) $((MB * 1000000000 / total_ns))
+done
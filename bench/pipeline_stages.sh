@@ -0,0 +1,37 @@
+#!/bin/bash
+# ============================================================
+#  pipeline_stages.sh - Pipeline de N etapes "cat"
+#
+#  Lance "echo x | cat | cat | ... | cat" (N cat) dans le shell et mesure
+#  le temps de lancement + traversee.
+#  Usage : bench/pipeline_stages.sh [N] [shell]   (N = 1000 par defaut)
+# ============================================================
+
+N=${1:-1000}
+SHELL_BIN=${2:-bin/shell}
+
+[ -x "$SHELL_BIN" ] || { echo "$SHELL_BIN introuvable (faire make)" >&2; exit 1; }
+INPUT=$(mktemp /tmp/bench_pipe_XXXXXX)
+OUTPUT=$(mktemp /tmp/bench_pipe_out_XXXXXX)
+trap "rm -f $INPUT $OUTPUT" EXIT
+
+{
+    printf '/bin/echo x'
+    for ((i = 0; i < N; i++)); do
+        printf ' | cat'
+    done
+    printf ' > %s\nquit\n' "$OUTPUT"
+} > "$INPUT"
+
+start=$(date +%s%N)
+"$SHELL_BIN" < "$INPUT" > /dev/null 2>&1
+end=$(date +%s%N)
+
+if [ "$(cat "$OUTPUT")" != "x" ]; then
+    echo "pipeline_stages: sortie incorrecte" >&2
+    exit 1
+fi
+
+total_ns=$((end - start))
+printf '{"bench":"pipeline_stages","stages":%d,"total_ms":%d,"per_stage_us":%d}\n' \
+    "$N" $((total_ns / 1000000)) $((total_ns / N / 1000))
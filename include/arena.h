@@ -0,0 +1,40 @@
+#ifndef __ARENA_H__
+#define __ARENA_H__
+
+#include <stddef.h>
+
+/* ========== Allocateur par bonds (arène) ==========
+ * Les allocations avancent un pointeur dans des blocs chaînés ; rien n'est
+ * libéré individuellement. arena_reset() rend toute l'arène en O(1) en
+ * gardant les blocs : une fois chaude, l'arène ne fait plus aucun appel
+ * à malloc. */
+
+typedef struct arena_chunk {
+    struct arena_chunk *next;
+    size_t size;                   // Octets utilisables dans data
+    size_t used;
+    char data[];
+} arena_chunk_t;
+
+typedef struct arena {
+    arena_chunk_t *head;           // Premier bloc
+    arena_chunk_t *cur;            // Bloc en cours de remplissage
+    unsigned long heap_calls;      // Blocs demandés à malloc depuis le début
+    size_t capacity;               // Taille totale des blocs
+} arena_t;
+
+#define ARENA_INITIALIZER { NULL, NULL, 0, 0 }
+
+/* Alloue n octets alignés pour tout type. Retourne NULL si malloc échoue. */
+void *arena_alloc(arena_t *a, size_t n);
+
+/* Copie les n premiers octets de s et ajoute '\0' */
+char *arena_strndup(arena_t *a, const char *s, size_t n);
+
+/* Oublie toutes les allocations (les blocs sont gardés) */
+void arena_reset(arena_t *a);
+
+/* Rend tous les blocs à malloc */
+void arena_free(arena_t *a);
+
+#endif /* __ARENA_H__ */
@@ -0,0 +1,30 @@
+#ifndef __DIRCACHE_H__
+#define __DIRCACHE_H__
+
+/* ========== Cache des listes de répertoires ==========
+ * Photo d'un répertoire (noms triés, stockés dans une seule arène), indexée
+ * par (périphérique, inode, mtime). Les globs d'une même ligne et des
+ * commandes suivantes réutilisent la même photo tant que le répertoire n'a
+ * pas changé ; inotify signale les changements que la mtime ne voit pas
+ * (plusieurs modifications dans le même tic d'horloge). */
+
+#define DIRCACHE_MAX_ENTRIES 100000   // Au-delà, pas de photo
+
+typedef struct dir_snapshot {
+    int count;               // Nombre d'entrées (sans "." ni "..")
+    char **names;            // Noms triés, pointent dans l'arène
+    unsigned char *types;    // DT_* de chaque nom (DT_UNKNOWN résolu)
+    int nfiles;              // Entrées qui ne sont pas des répertoires
+    char **files;            // Sous-ensemble de names, même ordre
+} dir_snapshot_t;
+
+/* Retourne la photo à jour du répertoire, ou NULL s'il est illisible.
+ * Un répertoire de plus de DIRCACHE_MAX_ENTRIES entrées n'est pas gardé :
+ * NULL avec errno = EFBIG, l'appelant le balaie lui-même (dir_scan).
+ * Le pointeur reste valide jusqu'au prochain appel. */
+const dir_snapshot_t *dircache_get(const char *dir);
+
+/* Oublie toutes les photos */
+void dircache_clear(void);
+
+#endif /* __DIRCACHE_H__ */
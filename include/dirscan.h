@@ -0,0 +1,59 @@
+#ifndef __DIRSCAN_H__
+#define __DIRSCAN_H__
+
+#include <stddef.h>
+#include "match.h"
+
+/* ========== Lecture de répertoires par getdents64 ==========
+ * Les entrées sont lues par gros lots dans un tampon réutilisé (un par
+ * thread) puis parcourues sur place, sans allocation par entrée. Le type
+ * vient de d_type ; fstatat n'est appelé que pour DT_UNKNOWN.
+ * Le tampon étant propre au thread, un thread n'a qu'un flux ouvert à la fois. */
+
+typedef struct dir_stream {
+    int fd;                  // Répertoire ouvert
+    char *buf;               // Tampon du thread
+    size_t len, pos;         // Octets lus / position courante
+} dir_stream_t;
+
+typedef struct dir_ent {
+    const char *name;        // Pointe dans le tampon : copier pour garder
+    size_t len;
+    unsigned char type;      // DT_*, éventuellement DT_UNKNOWN
+} dir_ent_t;
+
+/* Ouvre path relativement à dirfd (AT_FDCWD accepté). Retourne 0 ou -1. */
+int dirstream_open(dir_stream_t *s, int dirfd, const char *path);
+
+/* Entrée suivante, sans "." ni "..". Retourne 1, 0 à la fin, -1 si erreur. */
+int dirstream_next(dir_stream_t *s, dir_ent_t *e);
+
+/* Type de l'entrée ; résout DT_UNKNOWN par fstatat (sans suivre les liens) */
+unsigned char dirstream_type(dir_stream_t *s, dir_ent_t *e);
+
+void dirstream_close(dir_stream_t *s);
+
+/* Libère le tampon du thread appelant (à appeler avant la fin d'un thread) */
+void dirscan_thread_exit(void);
+
+/* ========== Balayage filtré ========== */
+
+#define SCAN_HIDDEN   1      // Garder les noms qui commencent par '.'
+#define SCAN_NO_DIRS  2      // Écarter les répertoires
+
+typedef struct scan_result {
+    char *arena;             // Noms retenus, bout à bout
+    char **names;            // Triés, pointent dans l'arène
+    unsigned char *types;    // Type de chaque nom (DT_UNKNOWN résolu)
+    int count;
+} scan_result_t;
+
+/* Lit le répertoire en ne copiant que les noms acceptés par g (tous si g
+ * est NULL). Au-delà de max noms (0 = sans limite), abandonne avec
+ * errno = EFBIG. Retourne 0, ou -1 en cas d'erreur. */
+int dir_scan(int dirfd, const char *path, const glob_pattern_t *g, int flags,
+             int max, scan_result_t *out);
+
+void scan_result_free(scan_result_t *r);
+
+#endif /* __DIRSCAN_H__ */
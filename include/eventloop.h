@@ -0,0 +1,30 @@
+#ifndef __EVENTLOOP_H__
+#define __EVENTLOOP_H__
+
+/* ========== Boucle d'événements (epoll + signalfd) ==========
+ * En mode événementiel, SIGCHLD reste bloqué en permanence et arrive par un
+ * signalfd. Le ramassage des fils, la mise à jour des jobs et les messages
+ * "Done" se font en contexte normal, dès que l'événement arrive, y compris
+ * pendant que l'utilisateur tape sa commande. */
+
+/* Active le mode événementiel. Retourne 0 si ça réussit, -1 sinon. */
+int evloop_init(void);
+
+/* Non nul si le mode événementiel est actif */
+int evloop_enabled(void);
+
+/* Attend que l'entrée standard soit lisible, en traitant les fins de jobs
+ * entre-temps (une seule passe de ramassage par rafale de SIGCHLD).
+ * Si buffered est non nul, une ligne attend déjà dans le tampon de lecture :
+ * on traite seulement les événements en attente, sans bloquer. */
+void evloop_wait_input(int buffered);
+
+/* Attend au moins un SIGCHLD puis ramasse tous les fils concernés */
+void evloop_wait_child(void);
+
+/* Descripteur lisible quand un SIGCHLD est en attente (à surveiller avec
+ * d'autres), et ramassage sans attente une fois qu'il l'est */
+int evloop_child_fd(void);
+void evloop_reap(void);
+
+#endif /* __EVENTLOOP_H__ */
@@ -0,0 +1,24 @@
+#ifndef __GLOBEXP_H__
+#define __GLOBEXP_H__
+
+/* ========== Expansion des motifs de chemins ==========
+ * Un motif est découpé en segments séparés par '/', par exemple
+ * "src/ma*.c" ou "/usr/lib/libc*.so". Un segment "**" vaut zéro ou plusieurs répertoires,
+ * et un '/' final ne garde que les répertoires.
+ * Un motif sans '/' se résout sur la liste en cache du répertoire courant.
+ * Les autres sont parcourus par un groupe de threads qui ouvrent chaque
+ * répertoire avec openat() relativement au répertoire de départ. Les
+ * résultats sont triés à la fin : l'ordre ne dépend pas de l'ordonnancement.
+ * Comme dans les autres shells, les jokers ne trouvent pas les noms qui
+ * commencent par '.' si le segment ne commence pas lui-même par '.', et **
+ * ne descend ni dans les répertoires cachés ni dans les liens symboliques. */
+
+/* Développe le motif. *matches reçoit un tableau de chaînes allouées
+ * (à libérer une par une, puis le tableau), *count leur nombre (0 si
+ * rien ne correspond). Retourne 0, ou -1 en cas d'erreur. */
+int glob_expand(const char *pattern, char ***matches, int *count);
+
+/* Nombre maximal de threads de parcours (0 = nombre de processeurs) */
+void glob_set_threads(int n);
+
+#endif /* __GLOBEXP_H__ */
@@ -0,0 +1,34 @@
+#ifndef __INPUT_H__
+#define __INPUT_H__
+
+#include <sys/types.h>
+
+/* ========== Lecture des lignes de commande ==========
+ * Lecture par blocs sur un rio_t (csapp), avec recherche des fins de ligne
+ * directement dans le tampon. Si l'entrée standard est un fichier régulier,
+ * il est projeté en mémoire d'un seul coup (mmap). Aucune allocation par
+ * ligne : une ligne contenue dans un bloc est rendue sur place, et seules
+ * les lignes à cheval sur deux blocs passent par un tampon réutilisé. */
+
+/* Lit les commandes sur fd au lieu de l'entrée standard (script) */
+void input_set_fd(int fd);
+
+/* Lit les commandes dans une chaîne (option -c) */
+void input_set_string(const char *str);
+
+/* Descripteur d'où viennent les commandes, -1 pour une chaîne (-c) */
+int input_fd(void);
+
+/* Non nul si la source des commandes est un fichier régulier */
+int input_is_regular_file(void);
+
+/* Lit la ligne suivante, sans le '\n' et non terminée par '\0'.
+ * *line reste valide jusqu'au prochain appel. Retourne la longueur, ou -1
+ * à la fin de l'entrée (une dernière ligne sans '\n' est rendue d'abord). */
+ssize_t input_readline(const char **line);
+
+/* Non nul si des octets déjà lus attendent dans le tampon : inutile alors
+ * d'attendre que l'entrée standard soit lisible. */
+int input_pending(void);
+
+#endif /* __INPUT_H__ */
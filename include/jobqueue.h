@@ -0,0 +1,42 @@
+#ifndef __JOBQUEUE_H__
+#define __JOBQUEUE_H__
+
+#include "shell.h"
+
+/* ========== File d'attente des jobs en arrière-plan ==========
+ * Un job lancé avec '&' alors que les limites de "set" (maxjobs, maxload,
+ * minmem) sont atteintes n'est pas lancé : il passe à l'état JOB_QUEUED,
+ * avec une copie de sa ligne de commande. Les jobs en file partent dans
+ * l'ordre d'arrivée dès qu'une place se libère : à chaque ramassage en mode
+ * événementiel, sinon au réveil du shell (ligne lue, attente d'un job, ou
+ * SIGCHLD reçu pendant l'attente de la ligne suivante). Tant qu'aucun job
+ * ne tourne, la file n'est pas retenue par la charge ni par la mémoire :
+ * elle ne peut pas rester bloquée faute de SIGCHLD. */
+
+/* Non nul si un nouveau job en arrière-plan peut partir tout de suite */
+int jobqueue_admit(void);
+
+/* Met la ligne en file (copiée) avec les options du pipeline.
+ * Retourne le numéro du job, ou -1 en cas d'erreur. */
+int jobqueue_enqueue(struct cmdline *l, const pipeline_opts_t *opts, const char *cmdline);
+
+/* Lance les jobs en file tant que les limites le permettent.
+ * Contexte normal uniquement (pas depuis un traitant de signal). */
+void jobqueue_dispatch(void);
+
+/* Lance tout de suite un job en file, sans tenir compte des limites :
+ * au premier plan (attendu, comme fg) ou en arrière-plan (comme bg) */
+void jobqueue_start(job_t *j, int bg);
+
+/* Nombre de jobs en file */
+int jobqueue_pending(void);
+
+/* Attend que fd soit lisible en lançant les jobs en file au fil des
+ * SIGCHLD (read() seul reprendrait sans rendre la main). Retourne aussitôt
+ * si la file est vide. */
+void jobqueue_wait_input(int fd);
+
+/* Attend que tous les jobs en file soient lancés (fin d'un script) */
+void jobqueue_drain(void);
+
+#endif /* __JOBQUEUE_H__ */
@@ -0,0 +1,12 @@
+#ifndef __LOADABLE_H__
+#define __LOADABLE_H__
+
+/* ========== Commandes intégrées chargeables (dlopen) ==========
+ * enable               liste les commandes chargées
+ * enable -f lib nom... charge "nom_builtin" depuis la bibliothèque lib
+ * enable -d nom...     décharge des commandes chargées
+ * L'ABI des bibliothèques est décrite dans msh_builtin.h. */
+
+int builtin_enable(char **args);
+
+#endif /* __LOADABLE_H__ */
@@ -1,7 +1,15 @@
 #ifndef __MATCH_H__
 #define __MATCH_H__
 
-int match_pattern(const char *pattern, char **candidates, int n, char ***selected, int *size);
-int list_dir(const char *dir, char ***content, int *size);
-int is_pattern(char *word);
-#endif
\ No newline at end of file
+#include <stddef.h>
+
+/* Glob pattern compiled once, matched in time linear in the name length.
+ * Supports '*', '?', bracket classes ([abc], [a-z], [!x]) and '\' escapes. */
+typedef struct glob_pattern glob_pattern_t;
+
+glob_pattern_t *glob_compile(const char *pattern);
+int glob_match(const glob_pattern_t *g, const char *name, size_t len);
+void glob_free(glob_pattern_t *g);
+int glob_has_magic(const char *word);
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef __MSH_BUILTIN_H__
+#define __MSH_BUILTIN_H__
+
+/* ========== ABI des commandes intégrées chargeables ==========
+ * Une bibliothèque partagée fournit une commande "nom" en exportant une
+ * variable globale "nom_builtin" de type msh_builtin_t :
+ *
+ *     #include "msh_builtin.h"
+ *     static int hello(char **args) { ... return 0; }
+ *     msh_builtin_t hello_builtin = {
+ *         MSH_BUILTIN_ABI_VERSION, "hello", hello, "Dit bonjour"
+ *     };
+ *
+ * puis se charge dans le shell avec : enable -f ./hello.so hello
+ * La fonction reçoit argv (args[0] = nom, terminé par NULL) et retourne le
+ * code de sortie. Ce fichier ne dépend d'aucun autre en-tête du shell. */
+
+#define MSH_BUILTIN_ABI_VERSION 1
+
+typedef struct {
+    int abi_version;               // Toujours MSH_BUILTIN_ABI_VERSION
+    const char *name;              // Nom de la commande
+    int (*func)(char **args);      // Fonction à exécuter
+    const char *description;       // Description affichée par help
+} msh_builtin_t;
+
+#endif /* __MSH_BUILTIN_H__ */
@@ -0,0 +1,22 @@
+#ifndef __PATHCACHE_H__
+#define __PATHCACHE_H__
+
+/* ========== Cache de résolution des commandes dans PATH ==========
+ * Table de hachage nom de commande -> chemin absolu, avec cache négatif pour
+ * les commandes introuvables. Le cache est vidé dès qu'un répertoire de PATH
+ * change (inotify) ou que la valeur de PATH elle-même change. Un répertoire
+ * absent est guetté via son parent ; si un élément de PATH ne peut pas être
+ * surveillé (relatif, vide), les commandes introuvables ne sont pas gardées. */
+
+/* Résout une commande. Retourne le chemin à passer à execve, ou NULL si la
+ * commande est introuvable. Un nom contenant '/' est retourné tel quel.
+ * Le pointeur reste valide jusqu'au prochain appel. */
+const char *path_lookup(const char *name);
+
+/* Oublie toutes les résolutions (hash -r) */
+void path_cache_clear(void);
+
+/* Commande intégrée : hash [-r] [nom ...] */
+int builtin_hash(char **args);
+
+#endif /* __PATHCACHE_H__ */
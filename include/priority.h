@@ -0,0 +1,33 @@
+#ifndef __PRIORITY_H__
+#define __PRIORITY_H__
+
+#include "shell.h"
+
+/* ========== Priorité des jobs en arrière-plan ==========
+ * Un job lancé avec '&' sous une politique autre que BGPRIO_OFF tourne avec
+ * une politique d'ordonnancement plus faible, un nice plus élevé et la
+ * classe d'E/S idle. fg lui rend la priorité du shell, bg la baisse de
+ * nouveau. La politique vient de "set bgprio" ou du préfixe "prio". */
+
+/* Nom d'une politique, et l'inverse (-1 si le nom est inconnu) */
+const char *bgprio_name(int prio);
+int bgprio_parse(const char *name);
+
+/* Dans le fils, avant exec : baisse la priorité du processus courant */
+void prio_lower_self(int prio);
+
+/* Baisse la priorité de pid selon prio, ou lui rend celle du shell si prio
+ * vaut BGPRIO_OFF. Retourne 0, ou -1 avec errno. */
+int prio_set_pid(pid_t pid, int prio);
+
+/* Applique à tous les processus vivants du job : sa politique si lowered,
+ * sinon la priorité du shell. Les échecs sont signalés sous le nom cmd. */
+void job_set_prio(job_t *j, int lowered, const char *cmd);
+
+/* Politique, nice et classe d'E/S courants de pid, pour jobs -l */
+char *prio_describe(pid_t pid, char *buf, size_t size);
+
+/* Commande intégrée : prio POLITIQUE %n... */
+int builtin_prio(char **args);
+
+#endif /* __PRIORITY_H__ */
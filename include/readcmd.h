@@ -5,11 +5,33 @@
 #ifndef __READCMD_H
 #define __READCMD_H
 
+#include <stddef.h>
+
 /* Read a command line from input stream. Return null when input closed.
-Display an error and call exit() in case of memory exhaustion. */
+Display an error and call exit() in case of memory exhaustion.
+The returned structure and all its strings live in an arena that is reset by
+the next call: copy anything that must outlive the line. */
 struct cmdline *readcmd(void);
 
 
+/* Parser counters, for benchmarks and allocation checks */
+struct readcmd_stats {
+	unsigned long lines;		/* Lines parsed so far */
+	unsigned long heap_calls;	/* malloc calls made by the parser (arena
+					   chunks, cmdline, glob expansions) */
+	size_t arena_bytes;		/* Current size of the line arena */
+	unsigned long cache_hits;	/* Lines found in the parse cache */
+	unsigned long cache_misses;	/* Lines tokenized and then cached */
+};
+
+void readcmd_get_stats(struct readcmd_stats *st);
+
+/* Enable or disable (and empty) the cache of tokenized lines. A line seen
+recently is not split again; globs and ~ are still expanded every time. */
+void readcmd_set_cache(int on);
+int readcmd_cache_enabled(void);
+
+
 /* Structure returned by readcmd() */
 struct cmdline {
 	char *err;	/* If not null, it is an error message that should be
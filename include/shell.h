@@ -9,6 +9,10 @@
 #include <sys/wait.h>
 #include <fcntl.h>
 #include <signal.h>
+#include <sched.h>
+#include <time.h>
+#include <sys/time.h>
+#include <sys/resource.h>
 #include "readcmd.h"
 
 /* ========== Couleurs ANSI ========== */
@@ -26,11 +30,28 @@ typedef struct {
     char *name;                    // Nom de la commande
     int (*func)(char **args);      // Fonction à exécuter (retourne 0 si ça réussit)
     char *description;             // Description de la commande
+    int has_external;              // 1 = existe aussi en programme externe, utilisé
+                                   //     dans un pipeline ou en arrière-plan
 } builtin_cmd_t;
 
+/* Code de sortie de la dernière commande de premier plan */
+extern int last_status;
+
+/* Signal (SIGINT ou SIGTSTP) reçu quand aucun job n'est au premier plan */
+extern volatile sig_atomic_t builtin_interrupted;
+
 /* Vérifier si c'est une commande intégrée et l'exécuter */
 int try_execute_builtin(char **cmd);
 
+/* Exécuter une commande intégrée avec redirections, dans le processus du shell */
+int run_builtin_redirected(builtin_cmd_t *b, char **cmd, char *input_file,
+                           char *output_file, int out_append);
+
+/* Registre des commandes intégrées (recherche par table de hachage) */
+builtin_cmd_t *find_builtin(const char *name);
+int builtin_register(const char *name, int (*func)(char **args), const char *description);
+int builtin_unregister(const char *name);
+
 /* Commandes intégrées */
 int builtin_quit(char **args);
 int builtin_exit(char **args);
@@ -40,41 +61,109 @@ int builtin_jobs(char **args);
 int builtin_fg(char **args);
 int builtin_bg(char **args);
 int builtin_stop(char **args);
+int builtin_set(char **args);
+int builtin_wait(char **args);
+int builtin_pin(char **args);
+
+/* Lancement d'une commande sur une liste d'entrées (parallel.c) */
+int builtin_parallel(char **args);
+
+/* Commandes intégrées rapides, sans fork/exec (fastbuiltins.c) */
+int builtin_echo(char **args);
+int builtin_printf(char **args);
+int builtin_true(char **args);
+int builtin_false(char **args);
+int builtin_test(char **args);
+int builtin_sleep(char **args);
+
+/* ========== Options du shell (commande set) ========== */
+typedef enum {
+    SPAWN_FORK,                    // fork() + execvp() (historique)
+    SPAWN_POSIX                    // posix_spawnp() : pas de copie de l'espace mémoire
+} spawn_mode_t;
+
+typedef enum {
+    BGPRIO_OFF,                    // Priorité du shell
+    BGPRIO_BATCH,                  // SCHED_BATCH, nice +10, E/S idle
+    BGPRIO_IDLE                    // SCHED_IDLE, nice 19, E/S idle
+} bg_prio_t;
+
+typedef struct {
+    spawn_mode_t spawn_mode;       // Méthode de lancement des processus
+    int pipe_size;                 // Capacité des pipes en octets (0 = défaut du noyau)
+    int interactive;               // Prompt et notifications des jobs (0 = script)
+    // Admission des jobs en arrière-plan (jobqueue.c), 0 = pas de limite
+    int max_jobs;                  // Jobs en cours au plus
+    double max_load;               // Charge moyenne sur 1 minute au plus
+    long min_mem;                  // MemAvailable minimale, en octets
+    bg_prio_t bg_prio;             // Priorité des jobs en arrière-plan (priority.c)
+} shell_options_t;
+
+extern shell_options_t shell_opts;
 
 /* ========== Gestion des jobs ========== */
-#define MAXJOBS 10
-#define MAX_PIPELINE 16
 
 typedef enum {
     JOB_RUNNING,
     JOB_STOPPED,
-    JOB_DONE
+    JOB_DONE,
+    JOB_QUEUED                     // En arrière-plan, pas encore lancé (jobqueue.c)
 } job_state_t;
 
+/* Consommation d'un processus du pipeline, relevée par wait4 à sa fin */
+typedef struct {
+    pid_t pid;
+    int done;                      // 1 une fois le processus terminé
+    struct timespec end;           // Instant de la terminaison (CLOCK_MONOTONIC)
+    struct rusage ru;              // Temps CPU, RSS max, changements de contexte
+} proc_usage_t;
+
 typedef struct {
-    int id;                        // Numéro du job (1-based, 0 = slot libre)
-    pid_t pgid;                    // Process Group ID (0 = slot libre)
-    pid_t pids[MAX_PIPELINE];      // PIDs des processus du pipeline
+    int id;                        // Numéro du job (1-based, 0 = premier plan sans numéro)
+    int slot;                      // Position dans job_list
+    pid_t pgid;                    // Process Group ID
+    pid_t *pids;                   // PIDs des processus du pipeline (num_procs)
+    int *pidfds;                   // pidfd de chaque processus, -1 une fois ramassé
     int num_procs;                 // Nombre de processus dans le pipeline
     int num_done;                  // Nombre de processus terminés
+    int status;                    // Code de sortie du dernier processus du pipeline
     job_state_t state;             // État courant
     int bg;                        // 1 = arrière-plan, 0 = premier plan
-    char cmdline[256];             // Texte de la commande pour affichage
+    char *cmdline;                 // Texte de la commande pour affichage
+    int pipe_size;                 // Capacité accordée aux pipes (0 = pas de pipe)
+    proc_usage_t *usage;           // Consommation de chaque processus (num_procs)
+    struct timespec start;         // Lancement (CLOCK_MONOTONIC)
+    struct timespec end;           // Fin du dernier processus
+    int timed;                     // Préfixe "time" : rapport à la fin du job
+    struct cmdline *queued;        // JOB_QUEUED : copie de la ligne à lancer
+    int prio;                      // Politique en arrière-plan (BGPRIO_*)
 } job_t;
 
-extern job_t jobs[MAXJOBS];
+/* Jobs vivants, tableau compact de num_jobs éléments (ordre quelconque) */
+extern job_t **job_list;
+extern int num_jobs;
 
 void init_jobs(void);
 int add_job(pid_t pgid, pid_t *pids, int num_procs, job_state_t state, int bg, const char *cmdline);
-void remove_job(pid_t pgid);
-job_t *find_job_by_pid(pid_t pgid);
+void remove_job(job_t *j);
+job_t *find_job_by_pid(pid_t pid);
 job_t *find_job_by_id(int id);
 job_t *get_fg_job(void);
 job_t *parse_job_ref(const char *ref);
 const char *job_state_str(job_state_t state);
-void check_completed_bg_jobs(void);
+int pending_bg_notifications(void);
+int check_completed_bg_jobs(void);
+void discard_completed_jobs(void);
+void print_job_usage(job_t *j, FILE *out, const char *indent);
+
+/* Envoie sig au groupe de processus du job par le pidfd d'un de ses
+ * processus vivants (pas de risque de réutilisation du pid) ; kill(-pgid)
+ * seulement si le noyau ne connaît pas les pidfds. Utilisable depuis un
+ * traitant de signal. Retourne 0, ou -1 avec errno. */
+int job_signal(job_t *j, int sig);
 
 /* ========== Traitants de signaux ========== */
+void reap_children(void);
 void sigchld_handler(int sig);
 void sigint_handler(int sig);
 void sigtstp_handler(int sig);
@@ -82,13 +171,37 @@ void sigtstp_handler(int sig);
 /* ========== Exécution ========== */
 void execute_cmdline(struct cmdline *l);
 void execute_simple_command(char **cmd, char *input_file, char *output_file, int out_append);
-void execute_pipeline(struct cmdline *l);
+/* Options d'un pipeline, données par des préfixes de la ligne de commande
+ * (ex. "pipesize 1M cmd1 | cmd2", "time cmd1 | cmd2", "pin 0-3 cmd",
+ * "prio idle cmd") ou, à défaut, par les options du shell */
+typedef struct {
+    int pipe_size;                 // Capacité demandée pour chaque pipe (0 = défaut)
+    int timed;                     // "time cmd" : temps et ressources de chaque étape
+    int pinned;                    // "pin CPUS cmd" : affinité de toutes les étapes
+    cpu_set_t cpus;
+    int prio;                      // "prio POLITIQUE cmd" : BGPRIO_* en arrière-plan
+    // Réservé aux commandes intégrées qui lancent des jobs (parallel)
+    int out_fd;                    // Sortie de la dernière étape (-1 : celle du shell)
+    int err_fd;                    // Sortie d'erreur des étapes (-1 : celle du shell)
+    int nowait;                    // Ni attente ni annonce : l'appelant suit le job
+    job_t *job;                    // En entrée : job en file à lancer (sinon NULL)
+                                   // En retour : job lancé, NULL si rien n'a été lancé
+} pipeline_opts_t;
+
+#define PIPELINE_OPTS_DEFAULT { .pipe_size = shell_opts.pipe_size, .prio = shell_opts.bg_prio, \
+                                .out_fd = -1, .err_fd = -1 }
+
+void execute_pipeline(struct cmdline *l, pipeline_opts_t *opts);
 void wait_for_fg_job(job_t *j);
 
 /* ========== Gestion des redirections ========== */
 void setup_redirections(char *input_file, char *output_file, int out_append);
 
 /* ========== Utilitaires ========== */
+void print_prompt(void);
+long parse_size(const char *str);
+int parse_cpu_list(const char *str, cpu_set_t *set);
+char *format_cpu_list(const cpu_set_t *set, char *buf, size_t size);
 void command_error(const char *cmd);
 int count_commands(char ***seq);
 char *trim_whitespace(char *str);
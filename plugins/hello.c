@@ -0,0 +1,15 @@
+/*
+ * Exemple de commande intégrée chargeable : enable -f bin/hello.so hello
+ */
+
+#include <stdio.h>
+#include "msh_builtin.h"
+
+static int hello(char **args) {
+    printf("Bonjour %s !\n", args[1] ? args[1] : "le monde");
+    return 0;
+}
+
+msh_builtin_t hello_builtin = {
+    MSH_BUILTIN_ABI_VERSION, "hello", hello, "Exemple de commande chargée"
+};
@@ -0,0 +1,71 @@
+/*
+ * Allocateur par bonds, remis à zéro à chaque ligne de commande.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdalign.h>
+#include <stddef.h>
+#include "arena.h"
+
+#define ARENA_FIRST_CHUNK 4096
+#define ARENA_ALIGN alignof(max_align_t)
+
+
+static arena_chunk_t *new_chunk(arena_t *a, size_t need) {
+    size_t size = a->cur ? a->cur->size * 2 : ARENA_FIRST_CHUNK;
+    while (size < need) size *= 2;
+
+    arena_chunk_t *c = malloc(sizeof(arena_chunk_t) + size);
+    if (c == NULL) return NULL;
+    a->heap_calls++;
+    a->capacity += size;
+    c->next = NULL;
+    c->size = size;
+    c->used = 0;
+    return c;
+}
+
+void *arena_alloc(arena_t *a, size_t n) {
+    n = (n + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+    if (n == 0) n = ARENA_ALIGN;
+
+    // Bloc courant plein : passer au suivant déjà alloué, ou en créer un
+    while (a->cur == NULL || a->cur->used + n > a->cur->size) {
+        arena_chunk_t *next = a->cur ? a->cur->next : a->head;
+        if (next == NULL) {
+            next = new_chunk(a, n);
+            if (next == NULL) return NULL;
+            if (a->cur) a->cur->next = next; else a->head = next;
+        }
+        next->used = 0;
+        a->cur = next;
+    }
+    void *p = a->cur->data + a->cur->used;
+    a->cur->used += n;
+    return p;
+}
+
+char *arena_strndup(arena_t *a, const char *s, size_t n) {
+    char *p = arena_alloc(a, n + 1);
+    if (p == NULL) return NULL;
+    memcpy(p, s, n);
+    p[n] = '\0';
+    return p;
+}
+
+void arena_reset(arena_t *a) {
+    a->cur = a->head;
+    if (a->head) a->head->used = 0;
+}
+
+void arena_free(arena_t *a) {
+    arena_chunk_t *c = a->head;
+    while (c != NULL) {
+        arena_chunk_t *next = c->next;
+        free(c);
+        c = next;
+    }
+    a->head = a->cur = NULL;
+    a->capacity = 0;
+}
@@ -893,6 +893,31 @@ ssize_t rio_readlineb(rio_t *rp, void *usrbuf, size_t maxlen)
 }
 /* $end rio_readlineb */
 
+/*
+ * rio_fillb - Make sure the internal buffer holds unread bytes, refilling
+ *    it with a single read() if it is empty. Returns the number of unread
+ *    bytes, which the caller may scan in place at rp->rio_bufptr and then
+ *    consume by advancing rio_bufptr and decrementing rio_cnt.
+ *    Returns 0 on EOF, -1 on error.
+ */
+/* $begin rio_fillb */
+ssize_t rio_fillb(rio_t *rp)
+{
+    while (rp->rio_cnt <= 0) {  /* Refill if buf is empty */
+	rp->rio_cnt = read(rp->rio_fd, rp->rio_buf, sizeof(rp->rio_buf));
+	if (rp->rio_cnt < 0) {
+	    if (errno != EINTR) /* Interrupted by sig handler return */
+		return -1;
+	}
+	else if (rp->rio_cnt == 0)  /* EOF */
+	    return 0;
+	else
+	    rp->rio_bufptr = rp->rio_buf; /* Reset buffer ptr */
+    }
+    return rp->rio_cnt;
+}
+/* $end rio_fillb */
+
 /**********************************
  * Wrappers for robust I/O routines
  **********************************/
@@ -0,0 +1,162 @@
+/*
+ * Cache des listes de répertoires pour l'expansion des globs.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/inotify.h>
+#include "dircache.h"
+#include "dirscan.h"
+
+#define DIRCACHE_SLOTS 32
+
+typedef struct dir_slot {
+    int used;
+    dev_t dev;                     // Clé : périphérique,
+    ino_t ino;                     //       inode
+    struct timespec mtime;         //       et date de modification
+    int wd;                        // Surveillance inotify (-1 si aucune)
+    int stale;                     // inotify a signalé un changement
+    int huge;                      // Trop d'entrées : rien n'est gardé
+    unsigned long last_use;        // Pour l'éviction LRU
+    scan_result_t scan;            // Noms triés dans une arène
+    dir_snapshot_t snap;
+} dir_slot_t;
+
+static dir_slot_t slots[DIRCACHE_SLOTS];
+static unsigned long use_clock = 0;
+static int inotify_fd = -1;
+static int inotify_tried = 0;
+
+
+static void free_slot(dir_slot_t *s) {
+    if (s->wd >= 0 && inotify_fd >= 0) inotify_rm_watch(inotify_fd, s->wd);
+    scan_result_free(&s->scan);
+    free(s->snap.files);
+    memset(s, 0, sizeof(*s));
+    s->wd = -1;
+}
+
+void dircache_clear(void) {
+    for (int i = 0; i < DIRCACHE_SLOTS; i++) {
+        if (slots[i].used) free_slot(&slots[i]);
+    }
+}
+
+// Marque comme périmées les photos dont le répertoire a bougé
+static void drain_events(void) {
+    char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    ssize_t len;
+
+    if (inotify_fd < 0) return;
+    while ((len = read(inotify_fd, buf, sizeof(buf))) > 0) {
+        for (char *p = buf; p < buf + len; ) {
+            struct inotify_event *ev = (struct inotify_event *)p;
+            // File d'événements débordée : des changements sont perdus, et
+            // la date de modification ne distingue pas ceux d'un même tic
+            int overflow = (ev->mask & IN_Q_OVERFLOW) != 0;
+            for (int i = 0; i < DIRCACHE_SLOTS; i++) {
+                if (slots[i].used && (overflow || slots[i].wd == ev->wd)) slots[i].stale = 1;
+            }
+            p += sizeof(struct inotify_event) + ev->len;
+        }
+    }
+}
+
+// Lit tout le répertoire (getdents64) et construit les index triés
+static int fill_slot(dir_slot_t *s, const char *dir) {
+    if (dir_scan(AT_FDCWD, dir, NULL, SCAN_HIDDEN, DIRCACHE_MAX_ENTRIES, &s->scan) != 0)
+        return -1;
+    s->snap.files = malloc((s->scan.count + 1) * sizeof(char *));
+    if (s->snap.files == NULL) {
+        scan_result_free(&s->scan);
+        return -1;
+    }
+    s->snap.count = s->scan.count;
+    s->snap.names = s->scan.names;
+    s->snap.types = s->scan.types;
+    s->snap.nfiles = 0;
+    for (int i = 0; i < s->scan.count; i++) {
+        if (s->scan.types[i] != DT_DIR) s->snap.files[s->snap.nfiles++] = s->scan.names[i];
+    }
+    return 0;
+}
+
+const dir_snapshot_t *dircache_get(const char *dir) {
+    struct stat st;
+    dir_slot_t *slot = NULL, *victim = &slots[0];
+
+    if (!inotify_tried) {
+        inotify_tried = 1;
+        inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        for (int i = 0; i < DIRCACHE_SLOTS; i++) slots[i].wd = -1;
+    }
+    drain_events();
+
+    if (stat(dir, &st) != 0 || !S_ISDIR(st.st_mode)) return NULL;
+
+    for (int i = 0; i < DIRCACHE_SLOTS; i++) {
+        dir_slot_t *s = &slots[i];
+        if (s->used && s->dev == st.st_dev && s->ino == st.st_ino) {
+            slot = s;
+            break;
+        }
+        if (!s->used) {
+            if (victim->used) victim = s;
+        } else if (victim->used && s->last_use < victim->last_use) {
+            victim = s;
+        }
+    }
+
+    // Un répertoire énorme est toujours balayé par l'appelant, changé ou non
+    if (slot != NULL && slot->huge) {
+        slot->last_use = ++use_clock;
+        errno = EFBIG;
+        return NULL;
+    }
+    if (slot != NULL && !slot->stale &&
+        slot->mtime.tv_sec == st.st_mtim.tv_sec &&
+        slot->mtime.tv_nsec == st.st_mtim.tv_nsec) {
+        slot->last_use = ++use_clock;
+        return &slot->snap;
+    }
+
+    // Absent ou périmé : on relit le répertoire
+    if (slot == NULL) slot = victim;
+    if (slot->used) free_slot(slot);
+
+    // Surveillance posée avant la lecture : aucun changement ne passe entre les deux
+    if (inotify_fd >= 0) {
+        slot->wd = inotify_add_watch(inotify_fd, dir, IN_CREATE | IN_DELETE | IN_MOVED_FROM |
+                                     IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR);
+    }
+    if (fill_slot(slot, dir) != 0) {
+        if (errno != EFBIG) {
+            int err = errno;
+            free_slot(slot);
+            errno = err;
+            return NULL;
+        }
+        // Répertoire énorme : on retient seulement qu'il l'est
+        if (slot->wd >= 0) inotify_rm_watch(inotify_fd, slot->wd);
+        slot->wd = -1;
+        slot->huge = 1;
+    }
+    slot->used = 1;
+    slot->dev = st.st_dev;
+    slot->ino = st.st_ino;
+    slot->mtime = st.st_mtim;
+    slot->stale = 0;
+    slot->last_use = ++use_clock;
+    if (slot->huge) {
+        errno = EFBIG;
+        return NULL;
+    }
+    return &slot->snap;
+}
@@ -0,0 +1,178 @@
+/*
+ * Lecture de répertoires par getdents64, filtrée au fil de l'eau.
+ */
+
+#define _GNU_SOURCE // qsort_r
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include "dirscan.h"
+
+#define DIRSCAN_BUF_SIZE (256 * 1024)
+#define ARENA_INIT 4096
+
+struct linux_dirent64 {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+
+static __thread char *thread_buf = NULL;   // Tampon getdents64 du thread
+
+
+void dirscan_thread_exit(void) {
+    free(thread_buf);
+    thread_buf = NULL;
+}
+
+int dirstream_open(dir_stream_t *s, int dirfd, const char *path) {
+    if (thread_buf == NULL) {
+        thread_buf = malloc(DIRSCAN_BUF_SIZE);
+        if (thread_buf == NULL) return -1;
+    }
+    s->fd = openat(dirfd, path[0] ? path : ".", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (s->fd < 0) return -1;
+    s->buf = thread_buf;
+    s->len = s->pos = 0;
+    return 0;
+}
+
+void dirstream_close(dir_stream_t *s) {
+    if (s->fd >= 0) close(s->fd);
+    s->fd = -1;
+}
+
+int dirstream_next(dir_stream_t *s, dir_ent_t *e) {
+    while (1) {
+        if (s->pos >= s->len) {
+            long n = syscall(SYS_getdents64, s->fd, s->buf, DIRSCAN_BUF_SIZE);
+            if (n < 0) return -1;
+            if (n == 0) return 0;
+            s->len = (size_t)n;
+            s->pos = 0;
+        }
+        struct linux_dirent64 *d = (struct linux_dirent64 *)(s->buf + s->pos);
+        s->pos += d->d_reclen;
+        const char *name = d->d_name;
+        if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0')))
+            continue;
+        e->name = name;
+        e->len = strlen(name);
+        e->type = d->d_type;
+        return 1;
+    }
+}
+
+static unsigned char mode_to_type(mode_t m) {
+    if (S_ISREG(m)) return DT_REG;
+    if (S_ISDIR(m)) return DT_DIR;
+    if (S_ISLNK(m)) return DT_LNK;
+    if (S_ISFIFO(m)) return DT_FIFO;
+    if (S_ISSOCK(m)) return DT_SOCK;
+    if (S_ISCHR(m)) return DT_CHR;
+    if (S_ISBLK(m)) return DT_BLK;
+    return DT_UNKNOWN;
+}
+
+unsigned char dirstream_type(dir_stream_t *s, dir_ent_t *e) {
+    struct stat st;
+    if (e->type == DT_UNKNOWN && fstatat(s->fd, e->name, &st, AT_SYMLINK_NOFOLLOW) == 0)
+        e->type = mode_to_type(st.st_mode);
+    return e->type;
+}
+
+/* ========== Balayage filtré ========== */
+
+typedef struct {
+    size_t off;
+    unsigned char type;
+} kept_t;
+
+static int cmp_kept(const void *a, const void *b, void *arena) {
+    const kept_t *x = a, *y = b;
+    return strcmp((char *)arena + x->off, (char *)arena + y->off);
+}
+
+void scan_result_free(scan_result_t *r) {
+    free(r->arena);
+    free(r->names);
+    free(r->types);
+    memset(r, 0, sizeof(*r));
+}
+
+int dir_scan(int dirfd, const char *path, const glob_pattern_t *g, int flags,
+             int max, scan_result_t *out) {
+    dir_stream_t s;
+    dir_ent_t e;
+    size_t cap = ARENA_INIT, used = 0, kcap = 64, count = 0;
+    char *arena = NULL;
+    kept_t *kept = NULL;
+    int r, err = 0;
+
+    memset(out, 0, sizeof(*out));
+    if (dirstream_open(&s, dirfd, path) != 0) return -1;
+    arena = malloc(cap);
+    kept = malloc(kcap * sizeof(kept_t));
+    if (arena == NULL || kept == NULL) err = ENOMEM;
+
+    // Le motif est appliqué sur le tampon : seuls les noms retenus sont copiés
+    while (!err && (r = dirstream_next(&s, &e)) > 0) {
+        if (e.name[0] == '.' && !(flags & SCAN_HIDDEN)) continue;
+        if (g != NULL && !glob_match(g, e.name, e.len)) continue;
+        if ((flags & SCAN_NO_DIRS) && dirstream_type(&s, &e) == DT_DIR) continue;
+        if (max > 0 && count == (size_t)max) { err = EFBIG; break; }
+
+        if (used + e.len + 1 > cap) {
+            while (used + e.len + 1 > cap) cap *= 2;
+            char *na = realloc(arena, cap);
+            if (na == NULL) { err = ENOMEM; break; }
+            arena = na;
+        }
+        if (count == kcap) {
+            kcap *= 2;
+            kept_t *nk = realloc(kept, kcap * sizeof(kept_t));
+            if (nk == NULL) { err = ENOMEM; break; }
+            kept = nk;
+        }
+        memcpy(arena + used, e.name, e.len + 1);
+        kept[count].off = used;
+        kept[count].type = dirstream_type(&s, &e);
+        count++;
+        used += e.len + 1;
+    }
+    if (!err && r < 0) err = errno;
+    dirstream_close(&s);
+
+    if (!err) {
+        out->names = malloc((count + 1) * sizeof(char *));
+        out->types = malloc(count + 1);
+        if (out->names == NULL || out->types == NULL) err = ENOMEM;
+    }
+    if (err) {
+        free(arena);
+        free(kept);
+        scan_result_free(out);
+        errno = err;
+        return -1;
+    }
+
+    qsort_r(kept, count, sizeof(kept_t), cmp_kept, arena);
+    for (size_t i = 0; i < count; i++) {
+        out->names[i] = arena + kept[i].off;
+        out->types[i] = kept[i].type;
+    }
+    out->names[count] = NULL;
+    out->arena = arena;
+    out->count = (int)count;
+    free(kept);
+    return 0;
+}
@@ -0,0 +1,115 @@
+/*
+ * Boucle d'événements : multiplexe l'entrée standard et SIGCHLD avec epoll.
+ */
+
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <poll.h>
+#include <errno.h>
+#include "shell.h"
+#include "eventloop.h"
+#include "jobqueue.h"
+
+static int sig_fd = -1;     // signalfd recevant SIGCHLD
+static int epoll_fd = -1;   // epoll sur stdin + sig_fd
+
+
+int evloop_enabled(void) {
+    return sig_fd >= 0;
+}
+
+int evloop_init(void) {
+    sigset_t mask_chld;
+    sigemptyset(&mask_chld);
+    sigaddset(&mask_chld, SIGCHLD);
+
+    // SIGCHLD n'est plus délivré au traitant mais lu sur le signalfd
+    sigprocmask(SIG_BLOCK, &mask_chld, NULL);
+
+    int sfd = signalfd(-1, &mask_chld, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (sfd < 0) {
+        perror("signalfd");
+        sigprocmask(SIG_UNBLOCK, &mask_chld, NULL);
+        return -1;
+    }
+
+    int efd = epoll_create1(EPOLL_CLOEXEC);
+    if (efd < 0) {
+        perror("epoll_create1");
+        close(sfd);
+        sigprocmask(SIG_UNBLOCK, &mask_chld, NULL);
+        return -1;
+    }
+
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.fd = STDIN_FILENO;
+    if (epoll_ctl(efd, EPOLL_CTL_ADD, STDIN_FILENO, &ev) < 0) {
+        // stdin non pollable (fichier régulier) : pas de mode événementiel
+        close(efd);
+        close(sfd);
+        sigprocmask(SIG_UNBLOCK, &mask_chld, NULL);
+        return -1;
+    }
+    ev.data.fd = sfd;
+    epoll_ctl(efd, EPOLL_CTL_ADD, sfd, &ev);
+
+    sig_fd = sfd;
+    epoll_fd = efd;
+    return 0;
+}
+
+// Vide le signalfd : une rafale de SIGCHLD ne donne qu'une passe de ramassage.
+// Les places libérées vont aussitôt aux jobs en file.
+static void drain_and_reap(void) {
+    struct signalfd_siginfo info[64];
+    while (read(sig_fd, info, sizeof(info)) > 0)
+        ;
+    reap_children();
+    jobqueue_dispatch();
+}
+
+int evloop_child_fd(void) {
+    return sig_fd;
+}
+
+void evloop_reap(void) {
+    drain_and_reap();
+}
+
+void evloop_wait_child(void) {
+    struct pollfd pfd = { .fd = sig_fd, .events = POLLIN };
+    if (poll(&pfd, 1, -1) > 0) {
+        drain_and_reap();
+    }
+}
+
+void evloop_wait_input(int buffered) {
+    struct epoll_event events[2];
+
+    while (1) {
+        int n = epoll_wait(epoll_fd, events, 2, buffered ? 0 : -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            perror("epoll_wait");
+            return;
+        }
+
+        int input_ready = 0;
+        for (int i = 0; i < n; i++) {
+            if (events[i].data.fd == sig_fd) {
+                drain_and_reap();
+                // Notification immédiate sur une nouvelle ligne, puis
+                // réafficher le prompt
+                if (pending_bg_notifications() > 0) {
+                    printf("\n");
+                    check_completed_bg_jobs();
+                    print_prompt();
+                }
+            } else {
+                input_ready = 1;
+            }
+        }
+        if (input_ready || buffered) return;
+    }
+}
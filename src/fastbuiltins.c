@@ -0,0 +1,563 @@
+/*
+ * Commandes intégrées rapides : echo, printf, true, false, test/[ et sleep.
+ * Elles s'exécutent dans le processus du shell (pas de fork ni d'exec) et
+ * suivent le comportement des versions de coreutils.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "shell.h"
+
+
+/* ============================================ */
+/* ========== Séquences d'échappement ========== */
+/* ============================================ */
+
+// Interprète la séquence commençant après '\' en *p et l'écrit sur stdout.
+// Avance *p. Retourne 0, ou 1 si c'est "\c" (arrêter toute sortie).
+// octal_zero : "\0nnn" (echo, %b) plutôt que "\nnn" (format de printf).
+static int put_escape(const char **p, int octal_zero) {
+    const char *s = *p;
+    int c = *s++;
+    int v, n;
+
+    switch (c) {
+        case 'a': putchar('\a'); break;
+        case 'b': putchar('\b'); break;
+        case 'c': *p = s; return 1;
+        case 'e': putchar('\033'); break;
+        case 'f': putchar('\f'); break;
+        case 'n': putchar('\n'); break;
+        case 'r': putchar('\r'); break;
+        case 't': putchar('\t'); break;
+        case 'v': putchar('\v'); break;
+        case '\\': putchar('\\'); break;
+        case 'x':
+            if (!isxdigit((unsigned char)*s)) {
+                putchar('\\');
+                putchar('x');
+                break;
+            }
+            for (v = 0, n = 0; n < 2 && isxdigit((unsigned char)*s); n++, s++) {
+                v = v * 16 + (isdigit((unsigned char)*s) ? *s - '0' : (tolower((unsigned char)*s) - 'a' + 10));
+            }
+            putchar(v);
+            break;
+        case '0': case '1': case '2': case '3':
+        case '4': case '5': case '6': case '7':
+            if (octal_zero && c != '0') {
+                putchar('\\');
+                putchar(c);
+                break;
+            }
+            v = octal_zero ? 0 : c - '0';
+            for (n = octal_zero ? 0 : 1; n < 3 && *s >= '0' && *s <= '7'; n++, s++) {
+                v = v * 8 + (*s - '0');
+            }
+            putchar(v & 0xff);
+            break;
+        case '\0':
+            putchar('\\');
+            s--;
+            break;
+        default:
+            putchar('\\');
+            putchar(c);
+    }
+    *p = s;
+    return 0;
+}
+
+// Écrit str en interprétant les échappements. Retourne 1 si "\c" rencontré.
+static int put_escaped(const char *str, int octal_zero) {
+    const char *p = str;
+    while (*p) {
+        if (*p == '\\') {
+            p++;
+            if (put_escape(&p, octal_zero)) return 1;
+        } else {
+            putchar(*p++);
+        }
+    }
+    return 0;
+}
+
+
+/* ============================================ */
+/* ========== echo, true, false ========== */
+/* ============================================ */
+
+// echo [-neE] [arg...] : comme /bin/echo de coreutils
+int builtin_echo(char **args) {
+    int newline = 1, escapes = 0;
+    int i = 1;
+
+    // Une option n'est reconnue que si tous ses caractères sont n, e ou E
+    for (; args[i] != NULL && args[i][0] == '-' && args[i][1] != '\0'; i++) {
+        if (strspn(args[i] + 1, "neE") != strlen(args[i] + 1)) break;
+        for (const char *o = args[i] + 1; *o; o++) {
+            if (*o == 'n') newline = 0;
+            else if (*o == 'e') escapes = 1;
+            else escapes = 0;
+        }
+    }
+
+    for (int first = 1; args[i] != NULL; i++, first = 0) {
+        if (!first) putchar(' ');
+        if (escapes) {
+            if (put_escaped(args[i], 1)) return 0;  // "\c" : fin de sortie
+        } else {
+            fputs(args[i], stdout);
+        }
+    }
+    if (newline) putchar('\n');
+    return 0;
+}
+
+int builtin_true(char **args) {
+    return 0;
+}
+
+int builtin_false(char **args) {
+    return 1;
+}
+
+
+/* ============================================ */
+/* ========== printf ========== */
+/* ============================================ */
+
+// Argument numérique de printf : "'c" donne le code du caractère
+static int printf_number(const char *arg, long long *ival, long double *fval, int floating) {
+    char *end;
+
+    if (arg[0] == '\'' || arg[0] == '"') {
+        *ival = (unsigned char)arg[1];
+        *fval = (unsigned char)arg[1];
+        return 0;
+    }
+    errno = 0;
+    if (floating) {
+        *fval = strtold(arg, &end);
+    } else if (arg[0] == '-') {
+        *ival = strtoll(arg, &end, 0);
+    } else {
+        *ival = (long long)strtoull(arg, &end, 0);
+    }
+    if (*arg == '\0' || *end != '\0' || errno == ERANGE) {
+        fprintf(stderr, COL_ROUGE "printf: '%s': valeur numérique attendue" COL_RESET "\n", arg);
+        return 1;
+    }
+    return 0;
+}
+
+// printf format [arg...] : le format est réappliqué tant qu'il reste des arguments
+int builtin_printf(char **args) {
+    if (args[1] == NULL) {
+        fprintf(stderr, COL_ROUGE "printf: opérande manquant" COL_RESET "\n");
+        return 1;
+    }
+
+    const char *format = args[1];
+    char **argp = args + 2;
+    int status = 0;
+
+    do {
+        char **start = argp;
+        for (const char *f = format; *f; ) {
+            if (*f == '\\') {
+                f++;
+                if (put_escape(&f, 0)) return status;
+                continue;
+            }
+            if (*f != '%') {
+                putchar(*f++);
+                continue;
+            }
+            if (f[1] == '%') {
+                putchar('%');
+                f += 2;
+                continue;
+            }
+
+            // Spécification : %[flags][largeur][.précision]conversion
+            char spec[64];
+            size_t len = 0;
+            int star_args[2], num_stars = 0;
+            spec[len++] = *f++;
+            while (*f && strchr("-+ #0", *f) && len < 40) spec[len++] = *f++;
+            for (int part = 0; part < 2; part++) {
+                if (part == 1) {
+                    if (*f != '.') break;
+                    spec[len++] = *f++;
+                }
+                if (*f == '*') {
+                    long long v = 0;
+                    long double fv;
+                    if (*argp != NULL) status |= printf_number(*argp++, &v, &fv, 0);
+                    star_args[num_stars++] = (int)v;
+                    spec[len++] = *f++;
+                } else {
+                    while (isdigit((unsigned char)*f) && len < 56) spec[len++] = *f++;
+                }
+            }
+
+            char conv = *f;
+            if (conv == '\0') {
+                fprintf(stderr, COL_ROUGE "printf: %s: conversion incomplète" COL_RESET "\n", format);
+                return 1;
+            }
+            f++;
+            const char *arg = *argp != NULL ? *argp++ : NULL;
+            long long ival = 0;
+            long double fval = 0;
+
+            switch (conv) {
+                case 'd': case 'i':
+                case 'o': case 'u': case 'x': case 'X':
+                    if (arg != NULL) status |= printf_number(arg, &ival, &fval, 0);
+                    spec[len++] = 'l';
+                    spec[len++] = 'l';
+                    spec[len++] = conv;
+                    spec[len] = '\0';
+                    if (num_stars == 2) printf(spec, star_args[0], star_args[1], ival);
+                    else if (num_stars == 1) printf(spec, star_args[0], ival);
+                    else printf(spec, ival);
+                    break;
+                case 'f': case 'F': case 'e': case 'E':
+                case 'g': case 'G': case 'a': case 'A':
+                    if (arg != NULL) status |= printf_number(arg, &ival, &fval, 1);
+                    spec[len++] = 'L';
+                    spec[len++] = conv;
+                    spec[len] = '\0';
+                    if (num_stars == 2) printf(spec, star_args[0], star_args[1], fval);
+                    else if (num_stars == 1) printf(spec, star_args[0], fval);
+                    else printf(spec, fval);
+                    break;
+                case 'c':
+                case 's':
+                    spec[len++] = conv;
+                    spec[len] = '\0';
+                    if (conv == 'c') {
+                        int ch = arg != NULL ? (unsigned char)arg[0] : '\0';
+                        if (num_stars == 1) printf(spec, star_args[0], ch);
+                        else printf(spec, ch);
+                    } else {
+                        const char *str = arg != NULL ? arg : "";
+                        if (num_stars == 2) printf(spec, star_args[0], star_args[1], str);
+                        else if (num_stars == 1) printf(spec, star_args[0], str);
+                        else printf(spec, str);
+                    }
+                    break;
+                case 'b':
+                    if (arg != NULL && put_escaped(arg, 1)) return status;
+                    break;
+                default:
+                    fprintf(stderr, COL_ROUGE "printf: %%%c: conversion invalide" COL_RESET "\n", conv);
+                    return 1;
+            }
+        }
+        // Aucun argument consommé : ne pas boucler indéfiniment
+        if (argp == start) break;
+    } while (*argp != NULL);
+
+    return status;
+}
+
+
+/* ============================================ */
+/* ========== test / [ ========== */
+/* ============================================ */
+
+typedef struct {
+    char **argv;
+    int pos;
+    int argc;
+    int error;                     // 1 = erreur de syntaxe (code 2)
+} test_state_t;
+
+static int test_expr_or(test_state_t *t);
+
+static int is_binary_op(const char *op) {
+    static const char *ops[] = {
+        "=", "==", "!=", "<", ">", "-eq", "-ne", "-lt", "-le", "-gt", "-ge",
+        "-nt", "-ot", "-ef", NULL
+    };
+    for (int i = 0; ops[i] != NULL; i++) {
+        if (strcmp(op, ops[i]) == 0) return 1;
+    }
+    return 0;
+}
+
+static int is_unary_op(const char *op) {
+    return op[0] == '-' && op[1] != '\0' && op[2] == '\0' &&
+           strchr("bcdefghLnprsStuwxzGO", op[1]) != NULL;
+}
+
+static long long test_integer(test_state_t *t, const char *s) {
+    char *end;
+    errno = 0;
+    long long v = strtoll(s, &end, 10);
+    while (*end == ' ' || *end == '\t') end++;
+    if (*s == '\0' || *end != '\0' || errno == ERANGE) {
+        fprintf(stderr, COL_ROUGE "test: %s: nombre entier attendu" COL_RESET "\n", s);
+        t->error = 1;
+    }
+    return v;
+}
+
+static int test_unary(test_state_t *t, char op, const char *arg) {
+    struct stat st;
+
+    switch (op) {
+        case 'n': return arg[0] != '\0';
+        case 'z': return arg[0] == '\0';
+        case 't': return isatty((int)test_integer(t, arg));
+        case 'r': return access(arg, R_OK) == 0;
+        case 'w': return access(arg, W_OK) == 0;
+        case 'x': return access(arg, X_OK) == 0;
+        case 'h':
+        case 'L': return lstat(arg, &st) == 0 && S_ISLNK(st.st_mode);
+    }
+    if (stat(arg, &st) != 0) return 0;
+    switch (op) {
+        case 'e': return 1;
+        case 'f': return S_ISREG(st.st_mode);
+        case 'd': return S_ISDIR(st.st_mode);
+        case 'b': return S_ISBLK(st.st_mode);
+        case 'c': return S_ISCHR(st.st_mode);
+        case 'p': return S_ISFIFO(st.st_mode);
+        case 'S': return S_ISSOCK(st.st_mode);
+        case 's': return st.st_size > 0;
+        case 'g': return (st.st_mode & S_ISGID) != 0;
+        case 'u': return (st.st_mode & S_ISUID) != 0;
+        case 'G': return st.st_gid == getegid();
+        case 'O': return st.st_uid == geteuid();
+    }
+    return 0;
+}
+
+static int test_binary(test_state_t *t, const char *a, const char *op, const char *b) {
+    if (strcmp(op, "=") == 0 || strcmp(op, "==") == 0) return strcmp(a, b) == 0;
+    if (strcmp(op, "!=") == 0) return strcmp(a, b) != 0;
+    if (strcmp(op, "<") == 0) return strcmp(a, b) < 0;
+    if (strcmp(op, ">") == 0) return strcmp(a, b) > 0;
+
+    if (strcmp(op, "-ef") == 0 || strcmp(op, "-nt") == 0 || strcmp(op, "-ot") == 0) {
+        struct stat sa, sb;
+        int ha = stat(a, &sa) == 0, hb = stat(b, &sb) == 0;
+        if (op[1] == 'e') {
+            return ha && hb && sa.st_dev == sb.st_dev && sa.st_ino == sb.st_ino;
+        }
+        // Fichier inexistant : plus ancien que tout fichier existant
+        int cmp = !ha ? (hb ? -1 : 0) : !hb ? 1 :
+                  sa.st_mtim.tv_sec != sb.st_mtim.tv_sec ?
+                      (sa.st_mtim.tv_sec > sb.st_mtim.tv_sec ? 1 : -1) :
+                      (sa.st_mtim.tv_nsec > sb.st_mtim.tv_nsec) - (sa.st_mtim.tv_nsec < sb.st_mtim.tv_nsec);
+        return op[1] == 'n' ? cmp > 0 : cmp < 0;
+    }
+
+    long long x = test_integer(t, a);
+    long long y = test_integer(t, b);
+    if (strcmp(op, "-eq") == 0) return x == y;
+    if (strcmp(op, "-ne") == 0) return x != y;
+    if (strcmp(op, "-lt") == 0) return x < y;
+    if (strcmp(op, "-le") == 0) return x <= y;
+    if (strcmp(op, "-gt") == 0) return x > y;
+    return x >= y;  // -ge
+}
+
+static const char *test_next(test_state_t *t) {
+    return t->pos < t->argc ? t->argv[t->pos] : NULL;
+}
+
+static int test_primary(test_state_t *t) {
+    const char *a = test_next(t);
+    if (a == NULL) {
+        fprintf(stderr, COL_ROUGE "test: argument attendu" COL_RESET "\n");
+        t->error = 1;
+        return 0;
+    }
+
+    // Opérateur binaire (prioritaire, ainsi "-n = -n" compare deux chaînes)
+    if (t->pos + 2 < t->argc && is_binary_op(t->argv[t->pos + 1])) {
+        t->pos += 3;
+        return test_binary(t, a, t->argv[t->pos - 2], t->argv[t->pos - 1]);
+    }
+    if (strcmp(a, "(") == 0 && t->pos + 1 < t->argc) {
+        t->pos++;
+        int r = test_expr_or(t);
+        if (test_next(t) == NULL || strcmp(test_next(t), ")") != 0) {
+            fprintf(stderr, COL_ROUGE "test: ')' attendue" COL_RESET "\n");
+            t->error = 1;
+            return 0;
+        }
+        t->pos++;
+        return r;
+    }
+    if (is_unary_op(a) && t->pos + 1 < t->argc) {
+        t->pos += 2;
+        return test_unary(t, a[1], t->argv[t->pos - 1]);
+    }
+    // Chaîne seule : vraie si non vide
+    t->pos++;
+    return a[0] != '\0';
+}
+
+static int test_expr_not(test_state_t *t) {
+    const char *a = test_next(t);
+    if (a != NULL && strcmp(a, "!") == 0 && t->pos + 1 < t->argc) {
+        t->pos++;
+        return !test_expr_not(t);
+    }
+    return test_primary(t);
+}
+
+static int test_expr_and(test_state_t *t) {
+    int r = test_expr_not(t);
+    while (test_next(t) != NULL && strcmp(test_next(t), "-a") == 0) {
+        t->pos++;
+        r = test_expr_not(t) && r;
+    }
+    return r;
+}
+
+static int test_expr_or(test_state_t *t) {
+    int r = test_expr_and(t);
+    while (test_next(t) != NULL && strcmp(test_next(t), "-o") == 0) {
+        t->pos++;
+        r = test_expr_and(t) || r;
+    }
+    return r;
+}
+
+// test expr / [ expr ] : 0 si vrai, 1 si faux, 2 en cas d'erreur
+int builtin_test(char **args) {
+    int argc = 0;
+    while (args[argc] != NULL) argc++;
+
+    if (strcmp(args[0], "[") == 0) {
+        if (argc < 2 || strcmp(args[argc - 1], "]") != 0) {
+            fprintf(stderr, COL_ROUGE "[: ']' manquant" COL_RESET "\n");
+            return 2;
+        }
+        argc--;
+    }
+
+    test_state_t t = { args, 1, argc, 0 };
+    if (argc == 1) return 1;  // Pas d'expression : faux
+
+    int r = test_expr_or(&t);
+    if (!t.error && t.pos < t.argc) {
+        fprintf(stderr, COL_ROUGE "test: argument en trop: %s" COL_RESET "\n", t.argv[t.pos]);
+        t.error = 1;
+    }
+    return t.error ? 2 : !r;
+}
+
+
+/* ============================================ */
+/* ========== sleep ========== */
+/* ============================================ */
+
+// Ctrl+Z pendant sleep : le reste de l'attente devient un job stoppé, dans
+// un processus fils, que fg et bg peuvent reprendre comme un /bin/sleep.
+static int sleep_suspend(char **args, struct timespec *rem) {
+    char cmdline[256];
+    cmdline[0] = '\0';
+    for (int i = 0; args[i] != NULL; i++) {
+        if (i > 0) strncat(cmdline, " ", sizeof(cmdline) - strlen(cmdline) - 1);
+        strncat(cmdline, args[i], sizeof(cmdline) - strlen(cmdline) - 1);
+    }
+
+    sigset_t mask_chld, prev_mask;
+    sigemptyset(&mask_chld);
+    sigaddset(&mask_chld, SIGCHLD);
+    sigprocmask(SIG_BLOCK, &mask_chld, &prev_mask);
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        sigprocmask(SIG_SETMASK, &prev_mask, NULL);
+        return 1;
+    }
+    if (pid == 0) {
+        signal(SIGINT, SIG_DFL);
+        signal(SIGTSTP, SIG_DFL);
+        signal(SIGCHLD, SIG_DFL);
+        sigprocmask(SIG_UNBLOCK, &mask_chld, NULL);
+        setpgid(0, 0);
+        while (nanosleep(rem, rem) < 0 && errno == EINTR)
+            ;
+        _exit(0);
+    }
+
+    setpgid(pid, pid);
+    kill(-pid, SIGSTOP);
+    int id = add_job(pid, &pid, 1, JOB_STOPPED, 1, cmdline);
+    sigprocmask(SIG_SETMASK, &prev_mask, NULL);
+
+    printf(COL_CYAN "[%d]" COL_RESET " " COL_JAUNE "Stopped" COL_RESET "\t\t" COL_ROSE "%s" COL_RESET "\n", id, cmdline);
+    return 128 + SIGTSTP;
+}
+
+#define SLEEP_MAX_SEC 0x1p62      // Bien représentable en time_t (64 bits)
+
+// sleep durée... : durées décimales avec suffixe s, m, h ou d, additionnées.
+// Ctrl+C interrompt l'attente (code 130), Ctrl+Z la suspend en job ;
+// SIGCHLD la fait seulement reprendre.
+int builtin_sleep(char **args) {
+    double total = 0;
+
+    if (args[1] == NULL) {
+        fprintf(stderr, COL_ROUGE "sleep: opérande manquant" COL_RESET "\n");
+        return 1;
+    }
+    for (int i = 1; args[i] != NULL; i++) {
+        char *end;
+        errno = 0;
+        double v = strtod(args[i], &end);
+        double mult = 1;
+        if (*end == 'm') mult = 60;
+        else if (*end == 'h') mult = 3600;
+        else if (*end == 'd') mult = 86400;
+        if (*end != '\0' && (strchr("smhd", *end) == NULL || end[1] != '\0')) v = -1;
+        if (end == args[i] || errno != 0 || !isfinite(v) || v < 0) {
+            fprintf(stderr, COL_ROUGE "sleep: intervalle invalide: '%s'" COL_RESET "\n", args[i]);
+            return 1;
+        }
+        total += v * mult;
+    }
+
+    // La somme peut dépasser ce que time_t représente : on la plafonne
+    // (le noyau plafonne lui-même vers 292 ans)
+    struct timespec req, rem;
+    if (total >= SLEEP_MAX_SEC) {
+        req.tv_sec = (time_t)SLEEP_MAX_SEC;
+        req.tv_nsec = 0;
+    } else {
+        req.tv_sec = (time_t)total;
+        req.tv_nsec = (long)((total - (double)req.tv_sec) * 1e9);
+    }
+
+    builtin_interrupted = 0;
+    while (nanosleep(&req, &rem) < 0 && errno == EINTR) {
+        int sig = builtin_interrupted;
+        builtin_interrupted = 0;
+        if (sig == SIGINT) {
+            return 128 + SIGINT;
+        }
+        if (sig == SIGTSTP) {
+            return sleep_suspend(args, &rem);
+        }
+        req = rem;
+    }
+    return 0;
+}
@@ -0,0 +1,455 @@
+/*
+ * Expansion des motifs de chemins : segments, ** et parcours parallèle.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <dirent.h>
+#include <signal.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include "match.h"
+#include "dircache.h"
+#include "dirscan.h"
+#include "globexp.h"
+
+#define GLOB_MAX_THREADS 8
+
+typedef struct {
+    char *text;                    // Segment littéral, échappements retirés
+    glob_pattern_t *pat;           // Motif compilé (NULL si littéral)
+    int globstar;                  // Segment "**"
+    int dot;                       // Commence par '.' : noms cachés permis
+} segment_t;
+
+typedef struct task {
+    char *path;                    // Répertoire, relatif au point de départ
+    int k;                         // Prochain segment à appliquer
+    struct task *next;
+} task_t;
+
+typedef struct {
+    char **items;
+    int n, cap;
+} result_vec_t;
+
+typedef struct walker {
+    int base_fd;                   // AT_FDCWD, ou "/" pour un motif absolu
+    const char *prefix;            // Préfixe des résultats ("" ou "/")
+    segment_t *segs;
+    int nsegs;
+    int dir_only;                  // Motif terminé par '/'
+
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    task_t *stack;                 // Répertoires à parcourir (LIFO)
+    int pending;                   // Tâches en attente + en cours
+    int idle;                      // Threads qui attendent du travail
+    int nthreads;                  // Threads actifs, appelant compris
+    _Atomic int error;             // Écrit par tous les threads, hors du verrou
+    pthread_t threads[GLOB_MAX_THREADS];
+    result_vec_t results[GLOB_MAX_THREADS];
+} walker_t;
+
+typedef struct {
+    walker_t *w;
+    int idx;
+} worker_arg_t;
+
+static int max_threads = 0;
+
+
+void glob_set_threads(int n) {
+    max_threads = n;
+}
+
+static int thread_limit(void) {
+    int n = max_threads;
+    if (n <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        n = cpus > 0 ? (int)cpus : 1;
+    }
+    return n > GLOB_MAX_THREADS ? GLOB_MAX_THREADS : n;
+}
+
+static int push_result(result_vec_t *r, char *s) {
+    if (s == NULL) return -1;
+    if (r->n == r->cap) {
+        int cap = r->cap ? r->cap * 2 : 32;
+        char **items = realloc(r->items, cap * sizeof(char *));
+        if (items == NULL) { free(s); return -1; }
+        r->items = items;
+        r->cap = cap;
+    }
+    r->items[r->n++] = s;
+    return 0;
+}
+
+static char *join_path(const char *dir, const char *name) {
+    size_t dl = strlen(dir), nl = strlen(name);
+    char *p = malloc(dl + nl + 2);
+    if (p == NULL) return NULL;
+    if (dl == 0) {
+        memcpy(p, name, nl + 1);
+    } else {
+        memcpy(p, dir, dl);
+        p[dl] = '/';
+        memcpy(p + dl + 1, name, nl + 1);
+    }
+    return p;
+}
+
+static void emit(walker_t *w, result_vec_t *r, const char *path) {
+    size_t pl = strlen(w->prefix), l = strlen(path);
+    char *s = malloc(pl + l + 2);
+    if (s != NULL) {
+        memcpy(s, w->prefix, pl);
+        memcpy(s + pl, path, l);
+        if (w->dir_only) s[pl + l++] = '/';
+        s[pl + l] = '\0';
+    }
+    if (push_result(r, s) != 0) w->error = 1;
+}
+
+/* ========== Groupe de threads ========== */
+
+static void *worker_main(void *arg);
+
+// Ajoute un répertoire à parcourir ; réveille ou crée un thread si besoin
+static void push_task(walker_t *w, char *path, int k) {
+    task_t *t = malloc(sizeof(task_t));
+    if (t == NULL) {
+        free(path);
+        w->error = 1;
+        return;
+    }
+    t->path = path;
+    t->k = k;
+
+    pthread_mutex_lock(&w->lock);
+    t->next = w->stack;
+    w->stack = t;
+    w->pending++;
+    if (w->idle > 0) {
+        pthread_cond_signal(&w->cond);
+    } else if (w->nthreads < thread_limit()) {
+        // Les threads de parcours ne reçoivent aucun signal du shell
+        worker_arg_t *a = malloc(sizeof(worker_arg_t));
+        sigset_t all, old;
+        sigfillset(&all);
+        pthread_sigmask(SIG_BLOCK, &all, &old);
+        if (a != NULL) {
+            a->w = w;
+            a->idx = w->nthreads;
+            if (pthread_create(&w->threads[a->idx], NULL, worker_main, a) == 0)
+                w->nthreads++;
+            else
+                free(a);
+        }
+        pthread_sigmask(SIG_SETMASK, &old, NULL);
+    }
+    pthread_mutex_unlock(&w->lock);
+}
+
+// Répertoire (en suivant les liens si follow) ? d_type évite le plus souvent fstatat
+static int is_dir(dir_stream_t *ds, dir_ent_t *de, int follow) {
+    struct stat st;
+    unsigned char type = dirstream_type(ds, de);
+    if (type == DT_DIR) return 1;
+    if (type != DT_LNK || !follow) return 0;
+    if (fstatat(ds->fd, de->name, &st, 0) != 0) return 0;
+    return S_ISDIR(st.st_mode);
+}
+
+/* Applique les segments k.. au répertoire path. Les segments littéraux sont
+ * simplement ajoutés au chemin ; un segment joker lit le répertoire une fois,
+ * en servant à la fois ** (descente) et le segment qui le suit. */
+static void run_task(walker_t *w, result_vec_t *r, char *path, int k) {
+    while (!w->segs[k].pat && !w->segs[k].globstar) {
+        char *next = join_path(path, w->segs[k].text);
+        free(path);
+        if (next == NULL) { w->error = 1; return; }
+        path = next;
+        if (k == w->nsegs - 1) {
+            struct stat st;
+            int flags = w->dir_only ? 0 : AT_SYMLINK_NOFOLLOW;
+            if (fstatat(w->base_fd, path, &st, flags) == 0 &&
+                (!w->dir_only || S_ISDIR(st.st_mode)))
+                emit(w, r, path);
+            free(path);
+            return;
+        }
+        k++;
+    }
+
+    int star2 = w->segs[k].globstar;
+    int mk = star2 ? k + 1 : k;          // Segment comparé aux noms lus
+    const segment_t *seg = &w->segs[mk];
+    int last = mk == w->nsegs - 1;
+
+    // ** suivi d'un littéral : pas besoin de lire le répertoire pour lui
+    if (star2 && seg->pat == NULL) {
+        char *copy = strdup(path);
+        if (copy != NULL) run_task(w, r, copy, mk);
+    }
+
+    dir_stream_t ds;
+    dir_ent_t de;
+    if (dirstream_open(&ds, w->base_fd, path) != 0) {
+        free(path);
+        return;
+    }
+
+    while (dirstream_next(&ds, &de) > 0) {
+        const char *name = de.name;
+        int hidden = name[0] == '.';
+
+        if (star2 && !hidden && is_dir(&ds, &de, 0)) {
+            char *sub = join_path(path, name);
+            if (sub != NULL) push_task(w, sub, k);
+        }
+        if (seg->pat == NULL || (hidden && !seg->dot)) continue;
+        if (!glob_match(seg->pat, name, de.len)) continue;
+
+        if (last) {
+            if (!w->dir_only || is_dir(&ds, &de, 1)) {
+                char *full = join_path(path, name);
+                if (full != NULL) emit(w, r, full);
+                free(full);
+            }
+        } else if (is_dir(&ds, &de, 1)) {
+            char *sub = join_path(path, name);
+            if (sub != NULL) push_task(w, sub, mk + 1);
+        }
+    }
+    dirstream_close(&ds);
+    free(path);
+}
+
+static void worker_loop(walker_t *w, result_vec_t *r) {
+    pthread_mutex_lock(&w->lock);
+    while (1) {
+        while (w->stack == NULL && w->pending > 0) {
+            w->idle++;
+            pthread_cond_wait(&w->cond, &w->lock);
+            w->idle--;
+        }
+        if (w->stack == NULL) break;
+
+        task_t *t = w->stack;
+        w->stack = t->next;
+        pthread_mutex_unlock(&w->lock);
+        run_task(w, r, t->path, t->k);
+        free(t);
+        pthread_mutex_lock(&w->lock);
+
+        if (--w->pending == 0) pthread_cond_broadcast(&w->cond);
+    }
+    pthread_mutex_unlock(&w->lock);
+}
+
+static void *worker_main(void *arg) {
+    worker_arg_t *a = arg;
+    worker_loop(a->w, &a->w->results[a->idx]);
+    dirscan_thread_exit();
+    free(a);
+    return NULL;
+}
+
+/* ========== Découpage du motif ========== */
+
+// Copie un segment littéral en retirant les '\'
+static char *unescape(const char *s, size_t len) {
+    char *out = malloc(len + 1);
+    size_t j = 0;
+    if (out == NULL) return NULL;
+    for (size_t i = 0; i < len; i++) {
+        if (s[i] == '\\' && i + 1 < len) i++;
+        out[j++] = s[i];
+    }
+    out[j] = '\0';
+    return out;
+}
+
+static void free_segments(segment_t *segs, int n) {
+    for (int i = 0; i < n; i++) {
+        free(segs[i].text);
+        glob_free(segs[i].pat);
+    }
+    free(segs);
+}
+
+static int add_segment(segment_t *segs, int *n, const char *s, size_t len) {
+    segment_t *seg = &segs[*n];
+    char *raw = strndup(s, len);
+    if (raw == NULL) return -1;
+
+    memset(seg, 0, sizeof(*seg));
+    if (strcmp(raw, "**") == 0) {
+        free(raw);
+        if (*n > 0 && segs[*n - 1].globstar) return 0;   // **/** = **
+        seg->globstar = 1;
+    } else if (glob_has_magic(raw)) {
+        seg->pat = glob_compile(raw);
+        seg->dot = raw[0] == '.';
+        free(raw);
+        if (seg->pat == NULL) return -1;
+    } else {
+        seg->text = unescape(raw, len);
+        free(raw);
+        if (seg->text == NULL) return -1;
+    }
+    (*n)++;
+    return 0;
+}
+
+// Découpe le motif ; un ** final devient "**" puis "*"
+static segment_t *split_pattern(const char *pattern, int *count, int *dir_only) {
+    size_t len = strlen(pattern);
+    segment_t *segs = calloc(len + 2, sizeof(segment_t));
+    int n = 0;
+
+    if (segs == NULL) return NULL;
+    *dir_only = len > 0 && pattern[len - 1] == '/';
+    for (const char *p = pattern; *p != '\0'; ) {
+        const char *end = strchr(p, '/');
+        size_t l = end ? (size_t)(end - p) : strlen(p);
+        if (l > 0 && add_segment(segs, &n, p, l) != 0) {
+            free_segments(segs, n);
+            return NULL;
+        }
+        p += l;
+        if (*p == '/') p++;
+    }
+    if (n > 0 && segs[n - 1].globstar && add_segment(segs, &n, "*", 1) != 0) {
+        free_segments(segs, n);
+        return NULL;
+    }
+    *count = n;
+    return segs;
+}
+
+static int cmp_str(const void *a, const void *b) {
+    return strcmp(*(char * const *)a, *(char * const *)b);
+}
+
+/* ========== Point d'entrée ========== */
+
+// Motif sans '/' : liste du répertoire courant en cache, déjà triée.
+// Un répertoire trop gros pour le cache est balayé avec le motif appliqué
+// au fil de la lecture : seuls les noms retenus sont copiés.
+static int expand_cwd(const char *pattern, char ***matches, int *count) {
+    const dir_snapshot_t *snap = dircache_get(".");
+    glob_pattern_t *g = glob_compile(pattern);
+    scan_result_t scan = {0};
+    result_vec_t r = {0};
+    int dot = pattern[0] == '.';
+    char **names;
+    int n, filtered = 0;
+
+    if (g == NULL) return -1;
+    if (snap != NULL) {
+        names = snap->names;
+        n = snap->count;
+    } else if (errno == EFBIG &&
+               dir_scan(AT_FDCWD, ".", g, dot ? SCAN_HIDDEN : 0, 0, &scan) == 0) {
+        names = scan.names;
+        n = scan.count;
+        filtered = 1;
+    } else {
+        glob_free(g);
+        return 0;
+    }
+
+    for (int i = 0; i < n; i++) {
+        const char *name = names[i];
+        if (name[0] == '.' && !dot) continue;
+        if ((filtered || glob_match(g, name, strlen(name))) &&
+            push_result(&r, strdup(name)) != 0) {
+            for (int j = 0; j < r.n; j++) free(r.items[j]);
+            free(r.items);
+            r.items = NULL;
+            r.n = -1;
+            break;
+        }
+    }
+    scan_result_free(&scan);
+    glob_free(g);
+    if (r.n < 0) return -1;
+    *matches = r.items;
+    *count = r.n;
+    return 0;
+}
+
+int glob_expand(const char *pattern, char ***matches, int *count) {
+    walker_t w;
+    int total = 0, status = 0;
+
+    *matches = NULL;
+    *count = 0;
+    if (strchr(pattern, '/') == NULL && strstr(pattern, "**") == NULL)
+        return expand_cwd(pattern, matches, count);
+
+    memset(&w, 0, sizeof(w));
+    w.segs = split_pattern(pattern, &w.nsegs, &w.dir_only);
+    if (w.segs == NULL) return -1;
+    if (w.nsegs == 0) {
+        free_segments(w.segs, 0);
+        return 0;
+    }
+    if (pattern[0] == '/') {
+        w.base_fd = open("/", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        w.prefix = "/";
+        if (w.base_fd < 0) {
+            free_segments(w.segs, w.nsegs);
+            return -1;
+        }
+    } else {
+        w.base_fd = AT_FDCWD;
+        w.prefix = "";
+    }
+    pthread_mutex_init(&w.lock, NULL);
+    pthread_cond_init(&w.cond, NULL);
+    w.nthreads = 1;
+
+    // L'appelant travaille aussi ; les autres threads naissent à la demande
+    char *root = strdup("");
+    if (root != NULL) {
+        push_task(&w, root, 0);
+        worker_loop(&w, &w.results[0]);
+    } else {
+        w.error = 1;
+    }
+    for (int i = 1; i < w.nthreads; i++) pthread_join(w.threads[i], NULL);
+
+    // Fusion déterministe : concaténation puis tri
+    for (int i = 0; i < w.nthreads; i++) total += w.results[i].n;
+    char **all = malloc((total + 1) * sizeof(char *));
+    int n = 0;
+    for (int i = 0; i < w.nthreads; i++) {
+        for (int j = 0; j < w.results[i].n; j++) {
+            if (all != NULL) all[n++] = w.results[i].items[j];
+            else free(w.results[i].items[j]);
+        }
+        free(w.results[i].items);
+    }
+    if (all == NULL || w.error) {
+        for (int i = 0; i < n; i++) free(all[i]);
+        free(all);
+        status = -1;
+    } else {
+        qsort(all, n, sizeof(char *), cmp_str);
+        *matches = all;
+        *count = n;
+    }
+
+    pthread_mutex_destroy(&w.lock);
+    pthread_cond_destroy(&w.cond);
+    if (w.base_fd >= 0) close(w.base_fd);
+    free_segments(w.segs, w.nsegs);
+    return status;
+}
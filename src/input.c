@@ -0,0 +1,134 @@
+/*
+ * Lecture des lignes de commande par blocs (rio_t) ou par mmap.
+ */
+
+#include "csapp.h"
+#include "input.h"
+
+static int initialized = 0;
+static int in_fd = STDIN_FILENO;  // Source des lignes
+static rio_t rio;                 // Lecture par blocs (tube, terminal)
+
+static const char *map = NULL;    // Fichier régulier projeté, ou chaîne -c
+static size_t map_len = 0, map_pos = 0;
+static int map_owned = 0;         // map vient de mmap
+
+static char *line_buf = NULL;     // Lignes à cheval sur deux blocs
+static size_t line_cap = 0;
+
+
+void input_set_fd(int fd) {
+    in_fd = fd;
+}
+
+void input_set_string(const char *str) {
+    initialized = 1;
+    in_fd = -1;
+    map = str;
+    map_len = strlen(str);
+    map_pos = 0;
+    map_owned = 0;
+}
+
+int input_fd(void) {
+    return in_fd;
+}
+
+int input_is_regular_file(void) {
+    struct stat st;
+    return fstat(in_fd, &st) == 0 && S_ISREG(st.st_mode);
+}
+
+static void input_init(void) {
+    struct stat st;
+    off_t off;
+
+    initialized = 1;
+    rio_readinitb(&rio, in_fd);
+
+    if (fstat(in_fd, &st) != 0 || !S_ISREG(st.st_mode)) return;
+    off = lseek(in_fd, 0, SEEK_CUR);
+    if (off < 0 || off >= st.st_size) return;
+
+    void *p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, in_fd, 0);
+    if (p == MAP_FAILED) return;
+    madvise(p, st.st_size, MADV_SEQUENTIAL);
+    map = p;
+    map_len = st.st_size;
+    map_pos = off;
+    map_owned = 1;
+    // Tout le fichier est lu : les commandes lancées voient la fin de fichier,
+    // et les octets ajoutés ensuite seront lus par blocs
+    lseek(in_fd, map_len, SEEK_SET);
+}
+
+static int append(const char *p, size_t n, size_t used) {
+    if (used + n > line_cap) {
+        size_t cap = line_cap ? line_cap : 256;
+        while (used + n > cap) cap *= 2;
+        char *nb = realloc(line_buf, cap);
+        if (nb == NULL) return -1;
+        line_buf = nb;
+        line_cap = cap;
+    }
+    memcpy(line_buf + used, p, n);
+    return 0;
+}
+
+ssize_t input_readline(const char **line) {
+    size_t used = 0;
+
+    if (!initialized) input_init();
+
+    if (map != NULL) {
+        if (map_pos < map_len) {
+            const char *start = map + map_pos;
+            const char *nl = memchr(start, '\n', map_len - map_pos);
+            size_t len = nl ? (size_t)(nl - start) : map_len - map_pos;
+            map_pos += len + (nl != NULL);
+            *line = start;
+            return len;
+        }
+        if (!map_owned) {
+            errno = 0;
+            return -1;            // Fin de la chaîne -c
+        }
+        munmap((void *)map, map_len);
+        map = NULL;
+    }
+
+    while (1) {
+        ssize_t n = rio_fillb(&rio);
+        if (n <= 0) {
+            // Fin de l'entrée : rendre la dernière ligne sans '\n'
+            errno = 0;
+            if (used == 0) return -1;
+            *line = line_buf;
+            return used;
+        }
+        char *start = rio.rio_bufptr;
+        char *nl = memchr(start, '\n', n);
+        size_t take = nl ? (size_t)(nl - start) : (size_t)n;
+
+        rio.rio_bufptr += take + (nl != NULL);
+        rio.rio_cnt -= take + (nl != NULL);
+        if (nl != NULL && used == 0) {
+            // Cas courant : la ligne entière est dans le bloc
+            *line = start;
+            return take;
+        }
+        if (append(start, take, used) != 0) {
+            errno = ENOMEM;
+            return -1;
+        }
+        used += take;
+        if (nl != NULL) {
+            *line = line_buf;
+            return used;
+        }
+    }
+}
+
+int input_pending(void) {
+    return (map != NULL && map_pos < map_len) || (initialized && rio.rio_cnt > 0);
+}
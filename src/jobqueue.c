@@ -0,0 +1,250 @@
+/*
+ * File d'attente des jobs en arrière-plan : admission selon le nombre de
+ * jobs en cours, la charge moyenne et la mémoire disponible.
+ */
+
+#define _GNU_SOURCE     // ppoll
+#include <errno.h>
+#include <poll.h>
+#include "shell.h"
+#include "jobqueue.h"
+#include "eventloop.h"
+
+typedef struct {
+    job_t *job;                    // Job à l'état JOB_QUEUED
+    pipeline_opts_t opts;          // Options du pipeline données à la mise en file
+} queue_entry_t;
+
+// Ordre d'arrivée : fifo[head..tail). Modifiée en contexte normal seulement.
+static queue_entry_t *fifo = NULL;
+static int head = 0, tail = 0, cap = 0;
+static int dispatching = 0;
+
+
+// MemAvailable en octets, -1 si /proc/meminfo est illisible
+static long mem_available(void) {
+    char buf[4096];
+    int fd = open("/proc/meminfo", O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+    ssize_t n = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if (n <= 0) return -1;
+    buf[n] = '\0';
+
+    char *p = strstr(buf, "MemAvailable:");
+    if (p == NULL) return -1;
+    return strtol(p + strlen("MemAvailable:"), NULL, 10) * 1024;
+}
+
+int jobqueue_admit(void) {
+    int running = 0;
+    for (int i = 0; i < num_jobs; i++) {
+        if (job_list[i]->state == JOB_RUNNING) running++;
+    }
+    if (shell_opts.max_jobs > 0 && running >= shell_opts.max_jobs) return 0;
+
+    // Sans job en cours, aucun SIGCHLD ne viendrait relancer la file
+    if (running == 0) return 1;
+
+    if (shell_opts.max_load > 0) {
+        double load;
+        if (getloadavg(&load, 1) == 1 && load >= shell_opts.max_load) return 0;
+    }
+    if (shell_opts.min_mem > 0) {
+        long avail = mem_available();
+        if (avail >= 0 && avail < shell_opts.min_mem) return 0;
+    }
+    return 1;
+}
+
+// Copie de la ligne en un seul bloc : la structure, les tableaux de mots,
+// puis les chaînes. Celle de readcmd ne vit que jusqu'à la ligne suivante.
+static struct cmdline *copy_cmdline(struct cmdline *l) {
+    int ncmds = count_commands(l->seq);
+    size_t nptrs = ncmds + 1, chars = 0;
+
+    for (int i = 0; i < ncmds; i++) {
+        for (int k = 0; l->seq[i][k] != NULL; k++) {
+            chars += strlen(l->seq[i][k]) + 1;
+            nptrs++;
+        }
+        nptrs++;
+    }
+    if (l->in) chars += strlen(l->in) + 1;
+    if (l->out) chars += strlen(l->out) + 1;
+
+    struct cmdline *c = malloc(sizeof(struct cmdline) + nptrs * sizeof(char *) + chars);
+    if (c == NULL) return NULL;
+    char ***seq = (char ***)(c + 1);
+    char **words = (char **)(seq + ncmds + 1);
+    char *text = (char *)(words + (nptrs - ncmds - 1));
+
+    *c = *l;
+    c->seq = seq;
+    for (int i = 0; i < ncmds; i++) {
+        seq[i] = words;
+        for (int k = 0; l->seq[i][k] != NULL; k++) {
+            *words++ = text;
+            text = stpcpy(text, l->seq[i][k]) + 1;
+        }
+        *words++ = NULL;
+    }
+    seq[ncmds] = NULL;
+    if (l->in) {
+        c->in = text;
+        text = stpcpy(text, l->in) + 1;
+    }
+    if (l->out) {
+        c->out = text;
+        stpcpy(text, l->out);
+    }
+    return c;
+}
+
+int jobqueue_enqueue(struct cmdline *l, const pipeline_opts_t *opts, const char *cmdline) {
+    if (tail == cap) {
+        // Place libérée en tête récupérée avant d'agrandir
+        if (head > 0) {
+            memmove(fifo, fifo + head, (tail - head) * sizeof(queue_entry_t));
+            tail -= head;
+            head = 0;
+        } else {
+            int ncap = cap ? cap * 2 : 16;
+            queue_entry_t *nf = realloc(fifo, ncap * sizeof(queue_entry_t));
+            if (nf == NULL) {
+                perror("realloc");
+                return -1;
+            }
+            fifo = nf;
+            cap = ncap;
+        }
+    }
+
+    struct cmdline *copy = copy_cmdline(l);
+    if (copy == NULL) {
+        perror("malloc");
+        return -1;
+    }
+    int id = add_job(0, NULL, 0, JOB_QUEUED, 1, cmdline);
+    job_t *j = find_job_by_id(id);
+    if (j == NULL) {
+        free(copy);
+        return -1;
+    }
+    j->queued = copy;
+    j->timed = opts->timed;
+    j->prio = opts->prio;
+    fifo[tail].job = j;
+    fifo[tail].opts = *opts;
+    tail++;
+    return id;
+}
+
+// Lance l'entrée (déjà retirée de la file) ; au premier plan, l'attend
+static void launch(queue_entry_t e, int bg) {
+    job_t *j = e.job;
+    struct cmdline *l = j->queued;
+    pipeline_opts_t opts = e.opts;
+
+    // Le job peut être retiré pendant l'attente : la ligne est détachée avant
+    j->queued = NULL;
+    l->bg = bg;
+    opts.prio = j->prio;           // Changée par "prio" pendant l'attente
+    opts.job = j;
+    opts.nowait = bg;              // Pas d'annonce "[n] pgid" à retardement
+    execute_pipeline(l, &opts);
+    free(l);
+}
+
+void jobqueue_dispatch(void) {
+    if (head == tail || dispatching) return;
+
+    // Un job en file qui échoue à se lancer ne touche pas au code de retour
+    // de la dernière commande de premier plan
+    int saved_status = last_status;
+    dispatching = 1;
+    while (head < tail && jobqueue_admit()) {
+        queue_entry_t e = fifo[head++];
+        launch(e, 1);
+    }
+    if (head == tail) head = tail = 0;
+    dispatching = 0;
+    last_status = saved_status;
+}
+
+void jobqueue_start(job_t *j, int bg) {
+    for (int i = head; i < tail; i++) {
+        if (fifo[i].job == j) {
+            queue_entry_t e = fifo[i];
+            memmove(&fifo[i], &fifo[i + 1], (tail - i - 1) * sizeof(queue_entry_t));
+            tail--;
+            if (head == tail) head = tail = 0;
+            launch(e, bg);
+            return;
+        }
+    }
+}
+
+int jobqueue_pending(void) {
+    return tail - head;
+}
+
+void jobqueue_drain(void) {
+    sigset_t mask_chld, prev_mask, wait_mask;
+    sigemptyset(&mask_chld);
+    sigaddset(&mask_chld, SIGCHLD);
+    sigprocmask(SIG_BLOCK, &mask_chld, &prev_mask);
+    wait_mask = prev_mask;
+    sigdelset(&wait_mask, SIGCHLD);
+
+    jobqueue_dispatch();
+    while (jobqueue_pending() > 0) {
+        if (evloop_enabled()) {
+            evloop_wait_child();
+        } else {
+            sigsuspend(&wait_mask);
+        }
+        jobqueue_dispatch();
+    }
+    sigprocmask(SIG_SETMASK, &prev_mask, NULL);
+}
+
+void jobqueue_wait_input(int fd) {
+    if (fd < 0) return;
+
+    sigset_t mask_chld, prev_mask, wait_mask;
+    sigemptyset(&mask_chld);
+    sigaddset(&mask_chld, SIGCHLD);
+    sigprocmask(SIG_BLOCK, &mask_chld, &prev_mask);
+    wait_mask = prev_mask;
+    // En mode événementiel, SIGCHLD reste bloqué et passe par le signalfd
+    if (!evloop_enabled()) sigdelset(&wait_mask, SIGCHLD);
+
+    // La charge et la mémoire baissent sans SIGCHLD : on les relit
+    // chaque seconde si ces limites sont posées
+    struct timespec tick = { 1, 0 };
+    const struct timespec *timeout =
+        shell_opts.max_load > 0 || shell_opts.min_mem > 0 ? &tick : NULL;
+
+    jobqueue_dispatch();
+    while (jobqueue_pending() > 0) {
+        struct pollfd pfds[2] = {
+            { .fd = fd, .events = POLLIN },
+            { .fd = evloop_enabled() ? evloop_child_fd() : -1, .events = POLLIN },
+        };
+        // Sans boucle d'événements, SIGCHLD n'est reçu que pendant ppoll :
+        // le traitant ramasse, puis la file repart ici, hors du traitant
+        int n = ppoll(pfds, 2, timeout, &wait_mask);
+        if (n < 0 && errno != EINTR) {
+            perror("ppoll");
+            break;
+        }
+        if (n > 0 && pfds[0].revents) break;
+        if (n > 0 && pfds[1].revents) {
+            evloop_reap();
+        } else {
+            jobqueue_dispatch();
+        }
+    }
+    sigprocmask(SIG_SETMASK, &prev_mask, NULL);
+}
@@ -0,0 +1,113 @@
+/*
+ * Commandes intégrées chargées dynamiquement depuis des bibliothèques partagées.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dlfcn.h>
+#include "shell.h"
+#include "msh_builtin.h"
+#include "loadable.h"
+
+typedef struct loaded_builtin {
+    char *name;                    // Nom de la commande
+    char *lib;                     // Bibliothèque d'origine
+    void *handle;                  // Référence dlopen (une par commande)
+    struct loaded_builtin *next;
+} loaded_builtin_t;
+
+static loaded_builtin_t *loaded = NULL;
+
+
+static int enable_load(const char *lib, const char *name) {
+    // Une référence dlopen par commande : décharger l'une ne ferme pas la
+    // bibliothèque tant que d'autres commandes l'utilisent
+    void *handle = dlopen(lib, RTLD_NOW | RTLD_LOCAL);
+    if (handle == NULL) {
+        fprintf(stderr, COL_ROUGE "enable: %s" COL_RESET "\n", dlerror());
+        return 1;
+    }
+
+    char sym[256];
+    snprintf(sym, sizeof(sym), "%s_builtin", name);
+    msh_builtin_t *def = dlsym(handle, sym);
+    if (def == NULL) {
+        fprintf(stderr, COL_ROUGE "enable: %s: symbole %s introuvable" COL_RESET "\n", lib, sym);
+        dlclose(handle);
+        return 1;
+    }
+    if (def->abi_version != MSH_BUILTIN_ABI_VERSION || def->name == NULL || def->func == NULL) {
+        fprintf(stderr, COL_ROUGE "enable: %s: ABI incompatible (version %d, attendue %d)" COL_RESET "\n",
+                name, def->abi_version, MSH_BUILTIN_ABI_VERSION);
+        dlclose(handle);
+        return 1;
+    }
+
+    loaded_builtin_t *lb = malloc(sizeof(loaded_builtin_t));
+    if (lb == NULL) {
+        perror("malloc");
+        dlclose(handle);
+        return 1;
+    }
+    lb->name = strdup(name);
+    lb->lib = strdup(lib);
+    lb->handle = handle;
+
+    if (builtin_register(lb->name, def->func, def->description) < 0) {
+        fprintf(stderr, COL_ROUGE "enable: %s: commande déjà définie" COL_RESET "\n", name);
+        free(lb->name);
+        free(lb->lib);
+        free(lb);
+        dlclose(handle);
+        return 1;
+    }
+    lb->next = loaded;
+    loaded = lb;
+    return 0;
+}
+
+static int enable_unload(const char *name) {
+    for (loaded_builtin_t **p = &loaded; *p != NULL; p = &(*p)->next) {
+        loaded_builtin_t *lb = *p;
+        if (strcmp(lb->name, name) == 0) {
+            builtin_unregister(name);
+            *p = lb->next;
+            dlclose(lb->handle);
+            free(lb->name);
+            free(lb->lib);
+            free(lb);
+            return 0;
+        }
+    }
+    fprintf(stderr, COL_ROUGE "enable: %s: pas une commande chargée" COL_RESET "\n", name);
+    return 1;
+}
+
+int builtin_enable(char **args) {
+    if (args[1] == NULL) {
+        for (loaded_builtin_t *lb = loaded; lb != NULL; lb = lb->next) {
+            printf("enable -f %s " COL_ROSE "%s" COL_RESET "\n", lb->lib, lb->name);
+        }
+        return 0;
+    }
+
+    int status = 0;
+    if (strcmp(args[1], "-f") == 0) {
+        if (args[2] == NULL || args[3] == NULL) {
+            fprintf(stderr, COL_ROUGE "enable: usage: enable -f bibliothèque nom..." COL_RESET "\n");
+            return 1;
+        }
+        for (int i = 3; args[i] != NULL; i++) {
+            status |= enable_load(args[2], args[i]);
+        }
+    } else if (strcmp(args[1], "-d") == 0) {
+        for (int i = 2; args[i] != NULL; i++) {
+            status |= enable_unload(args[i]);
+        }
+    } else {
+        fprintf(stderr, COL_ROUGE "enable: usage: enable [-f bibliothèque nom... | -d nom...]" COL_RESET "\n");
+        return 1;
+    }
+    return status;
+}
@@ -1,10 +1,46 @@
 #include "shell.h"
 #include "csapp.h"
 #include "readcmd.h"
+#include "eventloop.h"
+#include "input.h"
+#include "jobqueue.h"
 /* ============================================ */
 /* ========== MAIN ========== */
 /* ============================================ */
-int main() {
+int main(int argc, char **argv) {
+    int event_mode = 0;
+    const char *command = NULL;
+    int opt;
+
+    // Options : -e = boucle d'événements (epoll + signalfd)
+    //           -c commandes = exécuter la chaîne puis quitter
+    //           script = lire les commandes dans un fichier
+    while ((opt = getopt(argc, argv, "+ec:")) != -1) {
+        switch (opt) {
+            case 'e': event_mode = 1; break;
+            case 'c': command = optarg; break;
+            default:
+                fprintf(stderr, "usage: %s [-e] [-c commandes | script]\n", argv[0]);
+                exit(2);
+        }
+    }
+
+    // Source des commandes
+    if (command != NULL) {
+        input_set_string(command);
+    } else if (optind < argc) {
+        int fd = open(argv[optind], O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            fprintf(stderr, COL_ROUGE "%s: %s" COL_RESET "\n", argv[optind], strerror(errno));
+            exit(127);
+        }
+        input_set_fd(fd);
+    }
+
+    // Mode script (-c, fichier en argument ou redirigé sur l'entrée standard) :
+    // ni prompt ni notifications, code de retour de la dernière commande
+    shell_opts.interactive = command == NULL && optind >= argc && !input_is_regular_file();
+
     // Initialiser la table des jobs
     init_jobs();
 
@@ -29,26 +65,54 @@ int main() {
     sa.sa_flags = SA_RESTART;
     sigaction(SIGTSTP, &sa, NULL);
 
+    // Mode événementiel : SIGCHLD est traité en contexte normal
+    if (event_mode && shell_opts.interactive && evloop_init() < 0) {
+        fprintf(stderr, COL_ROUGE "boucle d'événements indisponible" COL_RESET "\n");
+    }
+
     while (1) {
         struct cmdline *l;
 
-        // Vérifier les jobs terminés en arrière-plan
-        check_completed_bg_jobs();
+        if (shell_opts.interactive) {
+            // Vérifier les jobs terminés en arrière-plan
+            check_completed_bg_jobs();
 
-        printf(COL_VIOLET "Mini-shell >>> " COL_RESET);
-        fflush(stdout);
+            print_prompt();
+
+            // Attendre l'entrée en signalant les fins de jobs au fil de l'eau
+            // (sans bloquer si des lignes déjà lues attendent dans le tampon)
+            if (evloop_enabled()) {
+                evloop_wait_input(input_pending());
+            }
+        } else if (num_jobs > 0) {
+            discard_completed_jobs();
+        }
+
+        // read() reprend après SIGCHLD (SA_RESTART) ou ne le voit pas (signalfd) :
+        // les jobs en file partent pendant l'attente de la ligne
+        if (jobqueue_pending() > 0 && !input_pending()) {
+            jobqueue_wait_input(input_fd());
+        }
 
         l = readcmd();
 
-        // EOF (Ctrl+D)
+        // Jobs en file dont la place s'est libérée pendant la lecture
+        jobqueue_dispatch();
+
+        // EOF (Ctrl+D, fin du script)
         if (!l) {
-            printf("\n" COL_VIOLET "exit" COL_RESET "\n");
-            exit(0);
+            // Les jobs en file partent avant la sortie, sans être attendus
+            jobqueue_drain();
+            if (shell_opts.interactive) {
+                printf("\n" COL_VIOLET "exit" COL_RESET "\n");
+            }
+            exit(last_status);
         }
 
         // Erreur de syntaxe
         if (l->err) {
             fprintf(stderr, COL_ROUGE "error: %s" COL_RESET "\n", l->err);
+            last_status = 2;
             continue;
         }
 
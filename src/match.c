@@ -1,91 +1,293 @@
 #include <stdlib.h>
 #include <string.h>
-#include <dirent.h>
+#include <stdint.h>
 #include "match.h"
-#include "stdio.h"
 
-int is_pattern(char *word) 
+/*
+ * Compiled glob patterns.
+ *
+ * A pattern is parsed once into a list of tokens: '*', or a set of bytes
+ * (a literal, '?', or a bracket class).  The leading and trailing runs of
+ * literal tokens are kept apart as a fixed prefix and suffix, checked with
+ * memcmp.  What is left in the middle is run as a bit-parallel NFA
+ * (shift-and): bit i of the state set means "the first i middle tokens
+ * have matched".  Each input byte costs one shift and a few masks per
+ * 64 tokens, so matching is linear in the length of the name whatever
+ * the number of stars.
+ */
+
+typedef struct {
+    int star;
+    int literal;            /* exactly one byte in set */
+    unsigned char c;        /* that byte, when literal */
+    uint64_t set[4];        /* 256-bit byte set */
+} glob_token_t;
+
+struct glob_pattern {
+    char *prefix;           /* literal head of the pattern */
+    size_t plen;
+    char *suffix;           /* literal tail of the pattern */
+    size_t slen;
+    size_t min_len;         /* number of non-star tokens */
+    int has_star;
+    int exact;              /* no wildcard at all: prefix is the whole pattern */
+
+    /* NFA for the middle tokens */
+    size_t ntok;
+    size_t words;           /* uint64_t words per state set */
+    uint64_t *chars;        /* [256][words]: bit i+1 if token i accepts the byte */
+    uint64_t *star_loop;    /* bit i+1 if token i is '*' (self loop) */
+    uint64_t *star_skip;    /* bit i if token i is '*' (empty match) */
+    int need;               /* a byte the middle must contain, or -1 */
+};
+
+static void set_add(uint64_t *set, unsigned char c)
 {
-    for(int i = 0; word[i] != '\0'; i++) 
-    {
-        if(word[i] == '*')
-            return 0;
-    }
-    return 1;
+    set[c >> 6] |= (uint64_t)1 << (c & 63);
 }
 
+static int set_has(const uint64_t *set, unsigned char c)
+{
+    return (set[c >> 6] >> (c & 63)) & 1;
+}
 
-/* Recursive pattern matching supporting '*' wildcard */
-static int match(const char *pattern, const char *candidate, int p, int c)
+/* Parse a bracket class starting at pattern[i] == '['.
+ * Returns the index just past ']', or 0 if the class is not terminated
+ * (the '[' is then a literal). */
+static size_t parse_class(const char *pattern, size_t i, glob_token_t *t)
 {
-    if (pattern[p] == '\0' && candidate[c] == '\0')
-        return 1;
-    if (pattern[p] == '\0' || candidate[c] == '\0') {
-        /* '*' can match empty string */
-        if (pattern[p] == '*' && pattern[p + 1] == '\0')
-            return 1;
-        return 0;
+    size_t j = i + 1;
+    int negate = 0;
+
+    memset(t, 0, sizeof(*t));
+    if (pattern[j] == '!' || pattern[j] == '^') {
+        negate = 1;
+        j++;
     }
-    if (pattern[p] == '*') {
-        /* Try matching zero or more characters */
-        for (int i = c; i <= (int)strlen(candidate); i++) {
-            if (match(pattern, candidate, p + 1, i))
-                return 1;
+    /* A ']' right after the opening bracket is a literal */
+    int first = 1;
+    while (pattern[j] != '\0' && (first || pattern[j] != ']')) {
+        unsigned char lo = (unsigned char)pattern[j];
+        if (lo == '\\' && pattern[j + 1] != '\0')
+            lo = (unsigned char)pattern[++j];
+        j++;
+        unsigned char hi = lo;
+        if (pattern[j] == '-' && pattern[j + 1] != '\0' && pattern[j + 1] != ']') {
+            j++;
+            hi = (unsigned char)pattern[j];
+            if (hi == '\\' && pattern[j + 1] != '\0')
+                hi = (unsigned char)pattern[++j];
+            j++;
         }
-        return 0;
+        for (unsigned c = lo; c <= hi; c++)
+            set_add(t->set, (unsigned char)c);
+        first = 0;
     }
-    if (pattern[p] != candidate[c])
+    if (pattern[j] != ']')
         return 0;
-    return match(pattern, candidate, p + 1, c + 1);
+    if (negate) {
+        for (int k = 0; k < 4; k++)
+            t->set[k] = ~t->set[k];
+    }
+    /* Never match the end-of-string byte */
+    t->set[0] &= ~(uint64_t)1;
+    return j + 1;
 }
 
-int list_dir(const char *dir, char ***content, int *size)
+/* Split the pattern into tokens; consecutive stars are merged */
+static glob_token_t *tokenize(const char *pattern, size_t *count)
 {
-    DIR *d = opendir(dir);
-    if (!d)
-        return 1;
+    size_t len = strlen(pattern);
+    glob_token_t *toks = malloc((len + 1) * sizeof(glob_token_t));
+    size_t n = 0;
 
-    struct dirent *entry;
-    *content = NULL;
-    *size = 0;
+    if (!toks)
+        return NULL;
+    for (size_t i = 0; pattern[i] != '\0'; ) {
+        glob_token_t *t = &toks[n];
+        if (pattern[i] == '*') {
+            i++;
+            if (n > 0 && toks[n - 1].star)
+                continue;
+            memset(t, 0, sizeof(*t));
+            t->star = 1;
+        } else if (pattern[i] == '?') {
+            i++;
+            memset(t, 0, sizeof(*t));
+            memset(t->set, 0xff, sizeof(t->set));
+            t->set[0] &= ~(uint64_t)1;
+        } else {
+            size_t next = 0;
+            if (pattern[i] == '[')
+                next = parse_class(pattern, i, t);
+            if (next) {
+                i = next;
+            } else {
+                unsigned char c = (unsigned char)pattern[i++];
+                if (c == '\\' && pattern[i] != '\0')
+                    c = (unsigned char)pattern[i++];
+                memset(t, 0, sizeof(*t));
+                t->literal = 1;
+                t->c = c;
+                set_add(t->set, c);
+            }
+        }
+        n++;
+    }
+    *count = n;
+    return toks;
+}
+
+void glob_free(glob_pattern_t *g)
+{
+    if (!g)
+        return;
+    free(g->prefix);
+    free(g->suffix);
+    free(g->chars);
+    free(g->star_loop);
+    free(g->star_skip);
+    free(g);
+}
+
+glob_pattern_t *glob_compile(const char *pattern)
+{
+    size_t n;
+    glob_token_t *toks = tokenize(pattern, &n);
+    glob_pattern_t *g = calloc(1, sizeof(*g));
+
+    if (!toks || !g) {
+        free(toks);
+        free(g);
+        return NULL;
+    }
+
+    size_t p = 0, s = 0;
+    while (p < n && toks[p].literal)
+        p++;
+    if (p == n) {
+        g->exact = 1;
+    } else {
+        while (s < n - p && toks[n - 1 - s].literal)
+            s++;
+    }
+    g->prefix = malloc(p + 1);
+    g->suffix = malloc(s + 1);
+    for (size_t i = 0; i < n; i++) {
+        if (toks[i].star)
+            g->has_star = 1;
+        else
+            g->min_len++;
+    }
 
-    while ((entry = readdir(d))) {
-        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0 || entry->d_type == 4)
+    g->ntok = n - p - s;
+    g->words = (g->ntok + 1 + 63) / 64;
+    g->chars = calloc(256 * g->words, sizeof(uint64_t));
+    g->star_loop = calloc(g->words, sizeof(uint64_t));
+    g->star_skip = calloc(g->words, sizeof(uint64_t));
+    if (!g->prefix || !g->suffix || !g->chars || !g->star_loop || !g->star_skip) {
+        free(toks);
+        glob_free(g);
+        return NULL;
+    }
+
+    for (size_t i = 0; i < p; i++)
+        g->prefix[i] = (char)toks[i].c;
+    g->plen = p;
+    for (size_t i = 0; i < s; i++)
+        g->suffix[i] = (char)toks[n - s + i].c;
+    g->slen = s;
+
+    g->need = -1;
+    for (size_t i = 0; i < g->ntok; i++) {
+        const glob_token_t *t = &toks[p + i];
+        size_t in = i / 64, out = (i + 1) / 64;
+        uint64_t bin = (uint64_t)1 << (i % 64), bout = (uint64_t)1 << ((i + 1) % 64);
+        if (t->star) {
+            g->star_skip[in] |= bin;
+            g->star_loop[out] |= bout;
             continue;
-        char **tmp = realloc(*content, sizeof(char *) * (*size + 1));
-        if (!tmp) {
-            for (int i = 0; i < *size; i++)
-                free((*content)[i]);
-            free(*content);
-            closedir(d);
-            return 1;
         }
-        *content = tmp;
-        (*content)[*size] = strdup(entry->d_name);
-        (*size)++;
+        if (t->literal && g->need < 0)
+            g->need = t->c;
+        for (unsigned c = 1; c < 256; c++) {
+            if (set_has(t->set, (unsigned char)c))
+                g->chars[c * g->words + out] |= bout;
+        }
     }
-    closedir(d);
-    return 0;
+    free(toks);
+    return g;
 }
 
-int match_pattern(const char *pattern, char **candidates, int n, char ***selected, int *size)
+/* Run the middle NFA over name[0..len) */
+static int nfa_match(const glob_pattern_t *g, const char *name, size_t len)
 {
-    *selected = NULL;
-    *size = 0;
-
-    for (int i = 0; i < n; i++) {
-        if (match(pattern, candidates[i], 0, 0)) {
-            char **tmp = realloc(*selected, sizeof(char *) * (*size + 1));
-            if (!tmp) {
-                for (int j = 0; j < *size; j++)
-                    free((*selected)[j]);
-                free(*selected);
+    size_t w = g->words;
+    uint64_t one[1], *d = w == 1 ? one : malloc(w * sizeof(uint64_t));
+    int matched;
+
+    if (!d)
+        return 0;
+    memset(d, 0, w * sizeof(uint64_t));
+    d[0] = 1;
+    /* Empty-match closure; stars are never adjacent, so one step is enough */
+    for (size_t k = w; k-- > 0; )
+        d[k] |= ((d[k] & g->star_skip[k]) << 1)
+              | (k > 0 ? (d[k - 1] & g->star_skip[k - 1]) >> 63 : 0);
+
+    for (size_t i = 0; i < len; i++) {
+        const uint64_t *mask = &g->chars[(unsigned char)name[i] * w];
+        uint64_t carry = 0, alive = 0;
+        for (size_t k = 0; k < w; k++) {
+            uint64_t cur = d[k];
+            d[k] = (((cur << 1) | carry) & mask[k]) | (cur & g->star_loop[k]);
+            carry = cur >> 63;
+        }
+        for (size_t k = w; k-- > 0; ) {
+            d[k] |= ((d[k] & g->star_skip[k]) << 1)
+                  | (k > 0 ? (d[k - 1] & g->star_skip[k - 1]) >> 63 : 0);
+            alive |= d[k];
+        }
+        if (!alive)
+            break;
+    }
+    matched = (d[g->ntok / 64] >> (g->ntok % 64)) & 1;
+    if (d != one)
+        free(d);
+    return matched;
+}
+
+int glob_match(const glob_pattern_t *g, const char *name, size_t len)
+{
+    if (g->exact)
+        return len == g->plen && memcmp(name, g->prefix, len) == 0;
+    if (len < g->min_len || (!g->has_star && len != g->min_len))
+        return 0;
+    if (memcmp(name, g->prefix, g->plen) != 0)
+        return 0;
+    if (memcmp(name + len - g->slen, g->suffix, g->slen) != 0)
+        return 0;
+
+    const char *mid = name + g->plen;
+    size_t mlen = len - g->plen - g->slen;
+    if (g->need >= 0 && !memchr(mid, g->need, mlen))
+        return 0;
+    return nfa_match(g, mid, mlen);
+}
+
+int glob_has_magic(const char *word)
+{
+    for (size_t i = 0; word[i] != '\0'; i++) {
+        if (word[i] == '\\') {
+            if (word[i + 1] != '\0')
+                i++;
+        } else if (word[i] == '*' || word[i] == '?') {
+            return 1;
+        } else if (word[i] == '[') {
+            glob_token_t t;
+            if (parse_class(word, i, &t))
                 return 1;
-            }
-            *selected = tmp;
-            (*selected)[*size] = strdup(candidates[i]);
-            (*size)++;
         }
     }
     return 0;
-}
\ No newline at end of file
+}
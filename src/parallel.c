@@ -0,0 +1,300 @@
+/*
+ * Commande intégrée parallel : lance une commande sur une liste d'arguments,
+ * au plus N à la fois, par la machinerie des jobs (execute_pipeline).
+ *
+ *   parallel [-j N] commande [args...] ::: arg1 arg2 ...
+ *   parallel [-j N] commande [args...] < liste     (une entrée par ligne)
+ *
+ * "{}" dans un mot est remplacé par l'entrée ; sans "{}", l'entrée est
+ * ajoutée en dernier argument. Les globs de la liste sont déjà développés
+ * par readcmd. La sortie (et la sortie d'erreur) de chaque job est capturée
+ * dans un memfd puis recopiée dans l'ordre des entrées : rien ne se mélange.
+ */
+
+#define _GNU_SOURCE     // memfd_create
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "shell.h"
+#include "eventloop.h"
+#include "jobqueue.h"
+
+// Sorties terminées mais pas encore recopiées (un job lent en tête bloque
+// la recopie) : au-delà, on attend avant de lancer, pour borner les memfd
+#define PARALLEL_WINDOW 256
+
+typedef struct {
+    job_t *job;                    // Job en cours, NULL sinon
+    int out, err;                  // Sorties capturées (-1 : pas de capture)
+    int done;
+} task_t;
+
+
+// Lit toutes les lignes non vides de l'entrée standard
+static char **read_lines(size_t *count) {
+    char *buf = NULL;
+    size_t len = 0, cap = 0, n = 0;
+    ssize_t r;
+
+    do {
+        if (len == cap) {
+            cap = cap ? cap * 2 : 4096;
+            char *nb = realloc(buf, cap + 1);
+            if (nb == NULL) { free(buf); return NULL; }
+            buf = nb;
+        }
+        r = read(STDIN_FILENO, buf + len, cap - len);
+        if (r > 0) len += r;
+    } while (r > 0 || (r < 0 && errno == EINTR));
+    if (buf == NULL) buf = malloc(1);
+    if (buf == NULL) return NULL;
+    buf[len] = '\0';
+
+    for (size_t i = 0; i < len; i++) if (buf[i] == '\n') n++;
+    // Le tableau et les lignes dans un seul bloc : une ligne par '\n' au plus,
+    // plus une dernière sans '\n'
+    char **lines = malloc((n + 2) * sizeof(char *) + len + 1);
+    if (lines == NULL) { free(buf); return NULL; }
+    char *text = (char *)(lines + n + 2);
+    memcpy(text, buf, len + 1);
+    free(buf);
+
+    n = 0;
+    for (char *p = text, *nl; *p != '\0'; p = nl + 1) {
+        nl = strchr(p, '\n');
+        if (nl == NULL) nl = p + strlen(p);
+        int last = *nl == '\0';
+        *nl = '\0';
+        if (*p != '\0') lines[n++] = p;
+        if (last) break;
+    }
+    lines[n] = NULL;
+    *count = n;
+    return lines;
+}
+
+// Remplace chaque "{}" de word par arg (résultat alloué)
+static char *substitute(const char *word, const char *arg) {
+    size_t alen = strlen(arg), n = 0;
+    for (const char *p = word; (p = strstr(p, "{}")) != NULL; p += 2) n++;
+
+    char *res = malloc(strlen(word) + n * alen + 1), *d = res;
+    if (res == NULL) return NULL;
+    for (const char *p = word, *q; ; p = q + 2) {
+        q = strstr(p, "{}");
+        size_t l = q ? (size_t)(q - p) : strlen(p);
+        memcpy(d, p, l);
+        d += l;
+        if (q == NULL) break;
+        memcpy(d, arg, alen);
+        d += alen;
+    }
+    *d = '\0';
+    return res;
+}
+
+static void free_argv(char **argv) {
+    if (argv == NULL) return;
+    for (int i = 0; argv[i] != NULL; i++) free(argv[i]);
+    free(argv);
+}
+
+// Arguments d'un job : le modèle, "{}" remplacé, ou l'entrée ajoutée à la fin
+static char **build_argv(char **templ, int ntempl, const char *arg) {
+    char **argv = calloc(ntempl + 2, sizeof(char *));
+    int replaced = 0;
+
+    if (argv == NULL) return NULL;
+    for (int i = 0; i < ntempl; i++) {
+        if (strstr(templ[i], "{}") != NULL) replaced = 1;
+        argv[i] = substitute(templ[i], arg);
+        if (argv[i] == NULL) { free_argv(argv); return NULL; }
+    }
+    if (!replaced && (argv[ntempl] = strdup(arg)) == NULL) {
+        free_argv(argv);
+        return NULL;
+    }
+    return argv;
+}
+
+// Lance un job sans l'attendre, l'entrée standard sur /dev/null
+static job_t *launch(char **argv, int out_fd, int err_fd) {
+    char **seq[2] = { argv, NULL };
+    struct cmdline l = { 0 };
+    pipeline_opts_t opts = PIPELINE_OPTS_DEFAULT;
+
+    l.seq = seq;
+    l.in = "/dev/null";
+    opts.out_fd = out_fd;
+    opts.err_fd = err_fd;
+    opts.nowait = 1;
+    execute_pipeline(&l, &opts);
+    return opts.job;
+}
+
+// Recopie une sortie capturée puis la ferme
+static void emit(int fd, int to) {
+    char buf[65536];
+    ssize_t n;
+
+    if (fd < 0) return;
+    lseek(fd, 0, SEEK_SET);
+    while ((n = read(fd, buf, sizeof(buf))) > 0) {
+        for (ssize_t off = 0; off < n; ) {
+            ssize_t w = write(to, buf + off, n - off);
+            if (w < 0 && errno == EINTR) continue;
+            if (w < 0) { n = 0; break; }
+            off += w;
+        }
+    }
+    close(fd);
+}
+
+static int usage(void) {
+    fprintf(stderr, COL_ROUGE "usage: parallel [-j N] commande [args...] [::: entrées...]" COL_RESET "\n");
+    return 2;
+}
+
+// parallel : code de retour 0 si tous les jobs ont réussi, sinon le nombre
+// d'échecs (plafonné à 101), 130 si interrompu par Ctrl+C
+int builtin_parallel(char **args) {
+    long max_jobs = sysconf(_SC_NPROCESSORS_ONLN);
+    int k = 1;
+
+    // Options
+    while (args[k] != NULL && args[k][0] == '-' && args[k][1] != '\0') {
+        if (strcmp(args[k], "--") == 0) { k++; break; }
+        if (strncmp(args[k], "-j", 2) != 0) return usage();
+        const char *v = args[k][2] != '\0' ? args[k] + 2 : args[++k];
+        char *end;
+        if (v == NULL) return usage();
+        max_jobs = strtol(v, &end, 10);
+        if (*end != '\0' || max_jobs <= 0 || max_jobs > INT_MAX) return usage();
+        k++;
+    }
+    if (max_jobs <= 0) max_jobs = 1;
+
+    // Modèle de commande, puis entrées après ":::" ou sur l'entrée standard
+    char **templ = args + k;
+    int ntempl = 0;
+    while (templ[ntempl] != NULL && strcmp(templ[ntempl], ":::") != 0) ntempl++;
+    if (ntempl == 0) return usage();
+
+    char **inputs, **lines = NULL;
+    size_t ninputs = 0;
+    if (templ[ntempl] != NULL) {
+        inputs = templ + ntempl + 1;
+        while (inputs[ninputs] != NULL) ninputs++;
+    } else {
+        lines = inputs = read_lines(&ninputs);
+        if (inputs == NULL) {
+            perror("parallel");
+            return 1;
+        }
+    }
+
+    task_t *tasks = calloc(ninputs ? ninputs : 1, sizeof(task_t));
+    size_t *running = malloc(max_jobs * sizeof(size_t));
+    if (tasks == NULL || running == NULL) {
+        free(tasks);
+        free(running);
+        free(lines);
+        perror("parallel");
+        return 1;
+    }
+
+    // SIGCHLD bloqué pendant tout le suivi, comme pour un job de premier plan
+    sigset_t mask_chld, prev_mask, wait_mask;
+    sigemptyset(&mask_chld);
+    sigaddset(&mask_chld, SIGCHLD);
+    sigprocmask(SIG_BLOCK, &mask_chld, &prev_mask);
+    wait_mask = prev_mask;
+    sigdelset(&wait_mask, SIGCHLD);
+
+    size_t next = 0, flushed = 0;
+    long nrun = 0, failed = 0;
+    int stop = 0, killed = 0;
+
+    builtin_interrupted = 0;
+    fflush(stdout);
+    while (1) {
+        // Lancer tant qu'il reste de la place
+        while (!stop && nrun < max_jobs && next < ninputs && next - flushed < PARALLEL_WINDOW) {
+            task_t *t = &tasks[next];
+            char **argv = build_argv(templ, ntempl, inputs[next]);
+            t->out = memfd_create("parallel.out", MFD_CLOEXEC);
+            t->err = memfd_create("parallel.err", MFD_CLOEXEC);
+            t->job = argv ? launch(argv, t->out, t->err) : NULL;
+            free_argv(argv);
+            if (t->job == NULL) {
+                // Commande introuvable (déjà signalé) ou mémoire épuisée
+                t->done = 1;
+                failed++;
+            } else {
+                running[nrun++] = next;
+            }
+            next++;
+        }
+
+        // Jobs terminés ; parallel ne se suspend pas : un Ctrl+Z est annulé
+        int progress = 0;
+        for (long r = 0; r < nrun; ) {
+            task_t *t = &tasks[running[r]];
+            job_t *j = t->job;
+            if (j->state == JOB_STOPPED) {
+                j->state = JOB_RUNNING;
+                j->bg = 0;
+                job_signal(j, SIGCONT);
+            }
+            if (j->state != JOB_DONE) {
+                r++;
+                continue;
+            }
+            if (j->status != 0) failed++;
+            if (j->status == 128 + SIGINT) stop = 1;
+            remove_job(j);
+            t->job = NULL;
+            t->done = 1;
+            running[r] = running[--nrun];
+            progress = 1;
+        }
+
+        // Sorties recopiées dans l'ordre des entrées
+        while (flushed < next && tasks[flushed].done) {
+            emit(tasks[flushed].out, STDOUT_FILENO);
+            emit(tasks[flushed].err, STDERR_FILENO);
+            flushed++;
+        }
+
+        // Ctrl+C : plus de lancement, et les jobs en cours sont interrompus
+        if (builtin_interrupted == SIGINT) {
+            builtin_interrupted = 0;
+            stop = 1;
+        }
+        if (stop && !killed) {
+            killed = 1;
+            for (long r = 0; r < nrun; r++) job_signal(tasks[running[r]].job, SIGINT);
+        }
+
+        if (nrun == 0 && (stop || next == ninputs)) break;
+        if (!progress && nrun > 0) {
+            if (evloop_enabled()) {
+                evloop_wait_child();
+            } else {
+                sigsuspend(&wait_mask);
+                jobqueue_dispatch();
+            }
+        }
+    }
+    sigprocmask(SIG_SETMASK, &prev_mask, NULL);
+
+    free(tasks);
+    free(running);
+    free(lines);
+    if (stop) return 128 + SIGINT;
+    return failed > 101 ? 101 : (int)failed;
+}
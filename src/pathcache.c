@@ -0,0 +1,292 @@
+/*
+ * Cache des chemins de commandes (équivalent de "hash" dans bash).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <limits.h>
+#include <sys/stat.h>
+#include <sys/inotify.h>
+#include "shell.h"
+#include "pathcache.h"
+
+#define PATHCACHE_INIT_BUCKETS 64
+
+typedef struct path_entry {
+    char *name;                    // Nom de la commande
+    char *path;                    // Chemin résolu (NULL = introuvable)
+    unsigned long hits;            // Nombre d'utilisations
+    struct path_entry *next;       // Chaînage dans le seau
+} path_entry_t;
+
+static path_entry_t **buckets = NULL;
+static size_t num_buckets = 0;
+static size_t num_entries = 0;
+
+static char *cached_path_var = NULL;   // Valeur de PATH lors du remplissage
+static int inotify_fd = -1;            // Surveille les répertoires de PATH
+static int watching_parents = 0;       // Un répertoire absent, surveillé via son parent
+static int path_unwatched = 0;         // Un répertoire de PATH n'est pas surveillé du tout
+
+
+// Hachage FNV-1a
+static size_t hash_name(const char *s) {
+    size_t h = 2166136261u;
+    while (*s) {
+        h ^= (unsigned char)*s++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+void path_cache_clear(void) {
+    for (size_t i = 0; i < num_buckets; i++) {
+        path_entry_t *e = buckets[i];
+        while (e != NULL) {
+            path_entry_t *next = e->next;
+            free(e->name);
+            free(e->path);
+            free(e);
+            e = next;
+        }
+        buckets[i] = NULL;
+    }
+    num_entries = 0;
+}
+
+static void grow_table(void) {
+    size_t new_size = num_buckets ? num_buckets * 2 : PATHCACHE_INIT_BUCKETS;
+    path_entry_t **nb = calloc(new_size, sizeof(path_entry_t *));
+    if (nb == NULL) return;  // On garde l'ancienne table, plus chargée
+
+    for (size_t i = 0; i < num_buckets; i++) {
+        path_entry_t *e = buckets[i];
+        while (e != NULL) {
+            path_entry_t *next = e->next;
+            size_t b = hash_name(e->name) & (new_size - 1);
+            e->next = nb[b];
+            nb[b] = e;
+            e = next;
+        }
+    }
+    free(buckets);
+    buckets = nb;
+    num_buckets = new_size;
+}
+
+#define WATCH_DIR_EVENTS (IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | \
+                          IN_ATTRIB | IN_DELETE_SELF | IN_MOVE_SELF)
+
+// Répertoire de PATH absent : on surveille le plus proche parent existant,
+// pour voir le répertoire apparaître. Retourne -1 si aucun ne convient.
+static int watch_nearest_parent(const char *dir) {
+    char buf[PATH_MAX];
+    if (dir[0] != '/' || strlen(dir) >= sizeof(buf)) return -1;
+    strcpy(buf, dir);
+
+    char *slash;
+    while ((slash = strrchr(buf, '/')) != NULL) {
+        slash[slash == buf ? 1 : 0] = '\0';
+        if (inotify_add_watch(inotify_fd, buf, IN_CREATE | IN_MOVED_TO |
+                              IN_DELETE_SELF | IN_MOVE_SELF) >= 0) {
+            return 0;
+        }
+        if (slash == buf) break;
+    }
+    return -1;
+}
+
+// (Re)pose les surveillances inotify sur chaque répertoire de PATH
+static void watch_path_dirs(const char *path_var) {
+    if (inotify_fd >= 0) close(inotify_fd);
+    watching_parents = 0;
+    path_unwatched = 1;
+    inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd < 0) return;
+
+    char *copy = strdup(path_var);
+    if (copy == NULL) return;
+    path_unwatched = 0;
+    char *save = NULL;
+    for (char *dir = strtok_r(copy, ":", &save); dir != NULL; dir = strtok_r(NULL, ":", &save)) {
+        // Un chemin relatif change de sens à chaque cd
+        if (dir[0] != '/') {
+            path_unwatched = 1;
+            continue;
+        }
+        if (inotify_add_watch(inotify_fd, dir, WATCH_DIR_EVENTS) >= 0) continue;
+        if (watch_nearest_parent(dir) == 0) {
+            watching_parents = 1;
+        } else {
+            path_unwatched = 1;
+        }
+    }
+    // Un élément vide désigne lui aussi le répertoire courant
+    size_t len = strlen(path_var);
+    if (len == 0 || path_var[0] == ':' || path_var[len - 1] == ':' ||
+        strstr(path_var, "::") != NULL) {
+        path_unwatched = 1;
+    }
+    free(copy);
+}
+
+// Vide le cache si PATH a changé ou si un répertoire surveillé a bougé
+static void sync_cache(void) {
+    const char *path_var = getenv("PATH");
+    if (path_var == NULL) path_var = "/usr/local/bin:/usr/bin:/bin";
+
+    if (cached_path_var == NULL || strcmp(cached_path_var, path_var) != 0) {
+        path_cache_clear();
+        free(cached_path_var);
+        cached_path_var = strdup(path_var);
+        watch_path_dirs(path_var);
+        return;
+    }
+
+    if (inotify_fd >= 0) {
+        char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+        ssize_t len;
+        int changed = 0, rewatch = watching_parents;
+        while ((len = read(inotify_fd, buf, sizeof(buf))) > 0) {
+            changed = 1;
+            for (char *p = buf; p < buf + len; ) {
+                struct inotify_event *ev = (struct inotify_event *)p;
+                // Débordement : des événements sont perdus, peut-être la
+                // disparition d'un répertoire. Surveillance retirée : le
+                // répertoire a disparu ou bougé.
+                if (ev->mask & (IN_Q_OVERFLOW | IN_IGNORED)) rewatch = 1;
+                p += sizeof(struct inotify_event) + ev->len;
+            }
+        }
+        if (changed) {
+            path_cache_clear();
+            // Un répertoire attendu a pu apparaître : le surveiller lui-même
+            if (rewatch) watch_path_dirs(cached_path_var);
+        }
+    }
+}
+
+// Parcourt PATH : premier fichier régulier exécutable trouvé
+static char *search_path(const char *name) {
+    const char *p = cached_path_var;
+    size_t name_len = strlen(name);
+    char candidate[PATH_MAX];
+    struct stat st;
+
+    while (1) {
+        const char *end = strchr(p, ':');
+        size_t dir_len = end ? (size_t)(end - p) : strlen(p);
+
+        // Un élément vide de PATH désigne le répertoire courant
+        if (dir_len + name_len + 2 <= sizeof(candidate)) {
+            if (dir_len == 0) {
+                memcpy(candidate, ".", 1);
+                dir_len = 1;
+            } else {
+                memcpy(candidate, p, dir_len);
+            }
+            candidate[dir_len] = '/';
+            memcpy(candidate + dir_len + 1, name, name_len + 1);
+            if (stat(candidate, &st) == 0 && S_ISREG(st.st_mode) &&
+                access(candidate, X_OK) == 0) {
+                return strdup(candidate);
+            }
+        }
+
+        if (end == NULL) return NULL;
+        p = end + 1;
+    }
+}
+
+static path_entry_t *find_entry(const char *name) {
+    if (num_buckets == 0) return NULL;
+    path_entry_t *e = buckets[hash_name(name) & (num_buckets - 1)];
+    while (e != NULL && strcmp(e->name, name) != 0) {
+        e = e->next;
+    }
+    return e;
+}
+
+static path_entry_t *resolve(const char *name) {
+    sync_cache();
+
+    path_entry_t *e = find_entry(name);
+    if (e != NULL) return e;
+
+    if (num_entries + 1 > num_buckets * 3 / 4) grow_table();
+    if (num_buckets == 0) return NULL;
+
+    char *path = search_path(name);
+    if (path == NULL && path_unwatched) {
+        // La commande peut apparaître sans que rien ne le signale : pas
+        // d'entrée négative, elle serait périmée
+        static path_entry_t uncached;
+        uncached.name = (char *)name;
+        uncached.path = NULL;
+        uncached.hits = 0;
+        return &uncached;
+    }
+
+    e = malloc(sizeof(path_entry_t));
+    if (e == NULL) {
+        free(path);
+        return NULL;
+    }
+    e->name = strdup(name);
+    e->path = path;               // NULL : entrée négative
+    e->hits = 0;
+
+    size_t b = hash_name(name) & (num_buckets - 1);
+    e->next = buckets[b];
+    buckets[b] = e;
+    num_entries++;
+    return e;
+}
+
+const char *path_lookup(const char *name) {
+    if (strchr(name, '/') != NULL) return name;
+
+    path_entry_t *e = resolve(name);
+    if (e == NULL) return name;  // Plus de mémoire : laisser exec chercher
+    e->hits++;
+    return e->path;
+}
+
+// hash : liste le cache ; hash -r le vide ; hash nom... résout et mémorise
+int builtin_hash(char **args) {
+    int status = 0;
+
+    if (args[1] == NULL) {
+        sync_cache();
+        if (num_entries == 0) {
+            printf("hash: table vide\n");
+            return 0;
+        }
+        printf("hits\tcommande\n");
+        for (size_t i = 0; i < num_buckets; i++) {
+            for (path_entry_t *e = buckets[i]; e != NULL; e = e->next) {
+                if (e->path != NULL) {
+                    printf("%4lu\t%s\n", e->hits, e->path);
+                } else {
+                    printf("%4lu\t%s " COL_ROUGE "(introuvable)" COL_RESET "\n", e->hits, e->name);
+                }
+            }
+        }
+        return 0;
+    }
+
+    for (int i = 1; args[i] != NULL; i++) {
+        if (strcmp(args[i], "-r") == 0) {
+            path_cache_clear();
+            continue;
+        }
+        path_entry_t *e = resolve(args[i]);
+        if (e == NULL || e->path == NULL) {
+            fprintf(stderr, COL_ROUGE "hash: %s: introuvable" COL_RESET "\n", args[i]);
+            status = 1;
+        }
+    }
+    return status;
+}
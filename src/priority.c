@@ -0,0 +1,161 @@
+/*
+ * Priorité des jobs en arrière-plan : politique d'ordonnancement, nice et
+ * classe d'E/S, baissées au lancement ou par bg, rétablies par fg.
+ */
+
+#define _GNU_SOURCE     // SCHED_BATCH, SCHED_IDLE
+#include <errno.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include "shell.h"
+#include "priority.h"
+
+// Valeurs de <linux/ioprio.h>, absent des en-têtes anciens
+#define IOPRIO_CLASS_SHIFT  13
+#define IOPRIO_CLASS_IDLE   3
+#define IOPRIO_WHO_PROCESS  1
+
+#define BATCH_NICE 10              // Décalage du nice en batch (idle : 19)
+
+typedef struct {
+    int policy;
+    struct sched_param param;
+    int nice;
+    int ioprio;
+} prio_t;
+
+static const char *prio_names[] = { "off", "batch", "idle" };
+
+
+const char *bgprio_name(int prio) {
+    return prio >= BGPRIO_OFF && prio <= BGPRIO_IDLE ? prio_names[prio] : "?";
+}
+
+int bgprio_parse(const char *name) {
+    for (int i = BGPRIO_OFF; i <= BGPRIO_IDLE; i++) {
+        if (strcmp(name, prio_names[i]) == 0) return i;
+    }
+    return -1;
+}
+
+static void get_prio(pid_t pid, prio_t *p) {
+    p->policy = sched_getscheduler(pid);
+    if (p->policy < 0 || sched_getparam(pid, &p->param) < 0) {
+        p->policy = SCHED_OTHER;
+        p->param.sched_priority = 0;
+    }
+    errno = 0;
+    p->nice = getpriority(PRIO_PROCESS, pid);
+    if (errno != 0) p->nice = 0;
+    p->ioprio = syscall(SYS_ioprio_get, IOPRIO_WHO_PROCESS, pid);
+    if (p->ioprio < 0) p->ioprio = 0;
+}
+
+// Priorité du shell, dont héritent les jobs : c'est celle que fg rétablit
+static const prio_t *shell_prio(void) {
+    static prio_t p;
+    static int known = 0;
+    if (!known) {
+        get_prio(0, &p);
+        known = 1;
+    }
+    return &p;
+}
+
+static void lowered_prio(int prio, const prio_t *base, prio_t *p) {
+    *p = *base;
+    p->policy = prio == BGPRIO_IDLE ? SCHED_IDLE : SCHED_BATCH;
+    p->param.sched_priority = 0;
+    p->nice = prio == BGPRIO_IDLE ? 19 : base->nice + BATCH_NICE;
+    if (p->nice > 19) p->nice = 19;
+    p->ioprio = IOPRIO_CLASS_IDLE << IOPRIO_CLASS_SHIFT;
+}
+
+// Les trois réglages sont propres au thread désigné : appliqués à un pid
+// déjà lancé, ils ne touchent que son thread principal
+static int apply_prio(pid_t pid, const prio_t *p) {
+    int ret = 0, err = 0;
+    if (sched_setscheduler(pid, p->policy, &p->param) < 0) { ret = -1; err = errno; }
+    if (setpriority(PRIO_PROCESS, pid, p->nice) < 0) { ret = -1; err = errno; }
+    if (syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, pid, p->ioprio) < 0) { ret = -1; err = errno; }
+    errno = err;
+    return ret;
+}
+
+void prio_lower_self(int prio) {
+    prio_t base, p;
+    get_prio(0, &base);
+    lowered_prio(prio, &base, &p);
+    apply_prio(0, &p);
+}
+
+int prio_set_pid(pid_t pid, int prio) {
+    prio_t p;
+    if (prio == BGPRIO_OFF) return apply_prio(pid, shell_prio());
+    lowered_prio(prio, shell_prio(), &p);
+    return apply_prio(pid, &p);
+}
+
+void job_set_prio(job_t *j, int lowered, const char *cmd) {
+    for (int i = 0; i < j->num_procs; i++) {
+        if (j->pids[i] == 0) continue;
+        // Un processus ramassé entre-temps (ESRCH) n'est pas une erreur ;
+        // sans privilège, le nice ne redescend pas au-dessous de RLIMIT_NICE
+        if (prio_set_pid(j->pids[i], lowered ? j->prio : BGPRIO_OFF) < 0 && errno != ESRCH) {
+            fprintf(stderr, COL_ROUGE "%s: priorité de %d: %s" COL_RESET "\n",
+                    cmd, j->pids[i], strerror(errno));
+        }
+    }
+}
+
+char *prio_describe(pid_t pid, char *buf, size_t size) {
+    prio_t p;
+    const char *policy, *io;
+    char io_be[16];
+
+    get_prio(pid, &p);
+    switch (p.policy) {
+        case SCHED_OTHER: policy = "normal"; break;
+        case SCHED_BATCH: policy = "batch"; break;
+        case SCHED_IDLE:  policy = "idle"; break;
+        default:          policy = "temps réel"; break;
+    }
+    switch (p.ioprio >> IOPRIO_CLASS_SHIFT) {
+        case 1:  io = "temps réel"; break;
+        case 2:
+            snprintf(io_be, sizeof(io_be), "be/%d", p.ioprio & ((1 << IOPRIO_CLASS_SHIFT) - 1));
+            io = io_be;
+            break;
+        case IOPRIO_CLASS_IDLE: io = "idle"; break;
+        default: io = "selon nice"; break;
+    }
+    snprintf(buf, size, "%s, nice %d, E/S %s", policy, p.nice, io);
+    return buf;
+}
+
+// prio POLITIQUE %n [%m...] : change la politique des jobs ; un job en
+// arrière-plan la prend aussitôt, un job en file à son lancement
+// (la forme "prio POLITIQUE commande" est un préfixe de pipeline)
+int builtin_prio(char **args) {
+    int prio = args[1] != NULL ? bgprio_parse(args[1]) : -1;
+    if (prio < 0 || args[2] == NULL) {
+        fprintf(stderr, COL_ROUGE "usage: prio off|batch|idle %%n... | prio off|batch|idle commande [| commande...]" COL_RESET "\n");
+        return 2;
+    }
+
+    int status = 0;
+    for (int k = 2; args[k] != NULL; k++) {
+        job_t *j = parse_job_ref(args[k]);
+        if (j == NULL) {
+            fprintf(stderr, COL_ROUGE "prio: %s: aucun travail correspondant" COL_RESET "\n", args[k]);
+            status = 1;
+            continue;
+        }
+        j->prio = prio;
+        if (j->bg && (j->state == JOB_RUNNING || j->state == JOB_STOPPED)) {
+            job_set_prio(j, 1, "prio");
+        }
+    }
+    return status;
+}
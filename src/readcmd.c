@@ -8,8 +8,12 @@
 #include <errno.h>
 #include <limits.h>
 #include <string.h>
+#include <stdint.h>
 #include "readcmd.h"
 #include "match.h"
+#include "globexp.h"
+#include "input.h"
+#include "arena.h"
 
 
 static void memory_error(void)
@@ -20,107 +24,80 @@ static void memory_error(void)
 }
 
 
-static void *xmalloc(size_t size)
+/* Every string and array of one command line lives in this arena. It is
+ * reset at the start of readcmd(), so a struct cmdline stays valid until the
+ * next call, as before. Once the arena has grown to fit the usual lines,
+ * parsing a line makes no heap call at all. */
+static arena_t line_arena = ARENA_INITIALIZER;
+static struct readcmd_stats stats;
+
+
+static void *amalloc(size_t size)
 {
-	void *p = malloc(size);
+	void *p = arena_alloc(&line_arena, size);
 	if (!p) memory_error();
 	return p;
 }
 
 
-static void *xrealloc(void *ptr, size_t size)
+static char *astrndup(const char *s, size_t n)
 {
-	void *p = realloc(ptr, size);
+	char *p = arena_strndup(&line_arena, s, n);
 	if (!p) memory_error();
 	return p;
 }
 
 
-/* Read a line from standard input and put it in a char[] */
-static char *readline(void)
-{
-	size_t buf_len = 16;
-	char *buf = xmalloc(buf_len * sizeof(char));
-
-	if (fgets(buf, buf_len, stdin) == NULL) {
-		free(buf);
-		return NULL;
-	}
-	
-	if (feof(stdin)) { /* End of file (ctrl-d) */
-	    fflush(stdout);
-	    exit(0);
-	}
-
-	do {
-		size_t l = strlen(buf);
-		if ((l > 0) && (buf[l-1] == '\n')) {
-			l--;
-			buf[l] = 0;
-			return buf;
-		}
-		if (buf_len >= (INT_MAX / 2)) memory_error();
-		buf_len *= 2;
-		buf = xrealloc(buf, buf_len * sizeof(char));
-		if (fgets(buf + l, buf_len - l, stdin) == NULL) return buf;
-	} while (1);
-}
-
 static int has_glob(const char *word)
 {
-	return strchr(word, '*') != NULL;
+	return glob_has_magic(word);
 }
 
-/* Expand glob patterns in the words array (e.g. *.c -> list of .c files) */
-static char **expand_globs(char **words)
+/* Expand glob patterns in the words array (e.g. *.c -> list of .c files).
+ * Matches are copied into the arena; words without magic are kept as-is. */
+static char **expand_globs(char **words, size_t n)
 {
-	char **result = NULL;
-	size_t result_len = 0;
-
-	for (int i = 0; words[i] != 0; i++) {
-		if (!has_glob(words[i])) {
-			/* Keep the word as-is */
-			result = xrealloc(result, (result_len + 2) * sizeof(char *));
-			result[result_len++] = words[i];
-			result[result_len] = 0;
-			continue;
+	struct expansion {
+		char **matched;
+		int size;
+	} *exp;
+	char **result;
+	size_t i, total = 0, l = 0;
+
+	for (i = 0; i < n && !has_glob(words[i]); i++)
+		;
+	if (i == n)
+		return words;
+
+	/* Word contains a wildcard: expand it (src/ma*.c, **, ...); the
+	 * current directory listing is cached across words and lines */
+	exp = amalloc(n * sizeof(*exp));
+	for (i = 0; i < n; i++) {
+		exp[i].size = 0;
+		if (has_glob(words[i])) {
+			stats.heap_calls++;
+			if (glob_expand(words[i], &exp[i].matched, &exp[i].size) != 0)
+				exp[i].size = 0;	/* Failed: keep the word as-is */
+			else if (exp[i].size == 0)
+				free(exp[i].matched);	/* No match: keep the literal pattern */
 		}
-		/* Word contains '*': expand it */
-		char **dir_content;
-		int dir_size;
-		if (list_dir(".", &dir_content, &dir_size) != 0) {
-			/* list_dir failed, keep the word as-is */
-			result = xrealloc(result, (result_len + 2) * sizeof(char *));
-			result[result_len++] = words[i];
-			result[result_len] = 0;
+		total += exp[i].size ? exp[i].size : 1;
+	}
+
+	result = amalloc((total + 1) * sizeof(char *));
+	for (i = 0; i < n; i++) {
+		if (exp[i].size == 0) {
+			result[l++] = words[i];
 			continue;
 		}
-		char **matched;
-		int match_size;
-		match_pattern(words[i], dir_content, dir_size, &matched, &match_size);
-
-		/* Free directory listing */
-		for (int j = 0; j < dir_size; j++)
-			free(dir_content[j]);
-		free(dir_content);
-
-		if (match_size == 0) {
-			/* No match: keep the literal pattern */
-			result = xrealloc(result, (result_len + 2) * sizeof(char *));
-			result[result_len++] = words[i];
-			result[result_len] = 0;
-			free(matched);
-		} else {
-			/* Replace the glob word with matched filenames */
-			free(words[i]);
-			result = xrealloc(result, (result_len + match_size + 1) * sizeof(char *));
-			for (int j = 0; j < match_size; j++)
-				result[result_len++] = matched[j];
-			result[result_len] = 0;
-			free(matched);
+		/* Replace the glob word with matched filenames */
+		for (int j = 0; j < exp[i].size; j++) {
+			result[l++] = astrndup(exp[i].matched[j], strlen(exp[i].matched[j]));
+			free(exp[i].matched[j]);
 		}
+		free(exp[i].matched);
 	}
-	free(words);
+	result[l] = 0;
 	return result;
 }
 
@@ -134,117 +111,206 @@ static char *expand_tilde(char *word)
 	if (!home)
 		return word;
 
-	/* "~" seul --> HOME */
-	if (word[1] == '\0') {
-		char *expanded = xmalloc(strlen(home) + 1);
-		strcpy(expanded, home);
-		free(word);
+	/* "~" seul --> HOME, "~/quelquechose" --> HOME/quelquechose */
+	if (word[1] == '\0' || word[1] == '/') {
+		size_t hlen = strlen(home), wlen = strlen(word + 1);
+		char *expanded = amalloc(hlen + wlen + 1);
+		memcpy(expanded, home, hlen);
+		memcpy(expanded + hlen, word + 1, wlen + 1);
 		return expanded;
 	}
+	return word;
+}
 
-	/* "~/quelquechose" --> HOME/quelquechose */
-	if (word[1] == '/') {
-		char *expanded = xmalloc(strlen(home) + strlen(word + 1) + 1);
-		strcpy(expanded, home);
-		strcat(expanded, word + 1);
-		free(word);
-		return expanded;
+
+/* Find the next word or operator in [*cur, end). Return its length, or 0 at
+ * the end of the line, and leave *cur just past it. */
+static size_t next_token(const char **cur, const char *end, const char **start)
+{
+	const char *p = *cur;
+
+	/* Ignore any whitespace */
+	while (p < end && (*p == ' ' || *p == '\t'))
+		p++;
+	*start = p;
+	if (p >= end || *p == 0) {
+		*cur = p;
+		return 0;
 	}
-	return word;
+	switch (*p) {
+	case '<':
+	case '|':
+	case '&':
+		p++;
+		break;
+	case '>':
+		p += (p + 1 < end && p[1] == '>') ? 2 : 1;
+		break;
+	default:
+		/* Another word */
+		while (p < end && *p && !strchr(" \t<>|&", *p))
+			p++;
+	}
+	*cur = p;
+	return p - *start;
 }
 
 
-/* Split the string in words, according to the simple shell grammar. */
-static char **split_in_words(char *line)
+/* Split the line in words, according to the simple shell grammar.
+ * The line is len bytes long and need not be null-terminated. A first pass
+ * counts the words so that the array is allocated once, at its exact size. */
+static char **split_in_words(const char *line, size_t len, size_t *nwords)
 {
-	char *cur = line;
-	char **tab = 0;
-	size_t l = 0;
-	char c;
-
-	while ((c = *cur) != 0) {
-		char *w = 0;
-		char *start;
-		switch (c) {
-		case ' ':
-		case '\t':
-			/* Ignore any whitespace */
-			cur++;
-			break;
-		case '<':
-			w = "<";
-			cur++;
-			break;
-		case '>':
-			if (*(cur+1) == '>') {
-				w = ">>";
-				cur += 2;
-			} else {
-				w = ">";
-				cur++;
-			}
-			break;
-		case '|':
-			w = "|";
-			cur++;
-			break;
-		case '&':
-			w = "&";
-			cur++;
-			break;
-		default:
-			/* Another word */
-			start = cur;
-			while (c) {
-				c = *++cur;
-				switch (c) {
-				case 0:
-				case ' ':
-				case '\t':
-				case '<':
-				case '>':
-				case '|':
-				case '&':
-					c = 0;
-					break;
-				default: ;
-				}
-			}
-			w = xmalloc((cur - start + 1) * sizeof(char));
-			strncpy(w, start, cur - start);
-			w[cur - start] = 0;
-		}
-		if (w) {
-			tab = xrealloc(tab, (l + 1) * sizeof(char *));
-			tab[l++] = w;
-		}
+	const char *cur, *start, *end = line + len;
+	char **tab;
+	size_t n = 0, l = 0, wlen;
+
+	for (cur = line; next_token(&cur, end, &start) != 0; )
+		n++;
+	tab = amalloc((n + 1) * sizeof(char *));
+	for (cur = line; (wlen = next_token(&cur, end, &start)) != 0; )
+		tab[l++] = astrndup(start, wlen);
+	tab[l] = 0;
+	*nwords = n;
+	return tab;
+}
+
+
+/* Cache of tokenized lines, for scripts and loops that repeat the same
+ * line. An entry keeps the raw line and its words as split_in_words() made
+ * them, before any expansion: globs and ~ depend on the directories and on
+ * HOME, so they are expanded again on every hit. Entries are reused in LRU
+ * order, and their buffers are kept, so a warm cache does not allocate. */
+#define LINE_CACHE_SLOTS 64
+#define LINE_CACHE_MAX_LINE 1024	/* Longer lines are not cached */
+
+struct line_entry {
+	uint64_t hash;
+	size_t len;		/* Length of the raw line, 0 if the slot is free */
+	size_t nwords;
+	size_t words_len;	/* Bytes of words, each null-terminated */
+	char *buf;		/* Raw line, then the words back to back */
+	size_t cap;
+	unsigned long last_use;
+};
+
+static struct line_entry line_cache[LINE_CACHE_SLOTS];
+static unsigned long line_clock = 0;
+static int line_cache_on = 1;
+
+
+static uint64_t hash_line(const char *line, size_t len)
+{
+	uint64_t h = 14695981039346656037ULL;	/* FNV-1a */
+
+	for (size_t i = 0; i < len; i++) {
+		h ^= (unsigned char)line[i];
+		h *= 1099511628211ULL;
 	}
-	tab = xrealloc(tab, (l + 1) * sizeof(char *));
-	tab[l++] = 0;
+	return h;
+}
+
+
+/* Rebuild the words of a cached line in the arena. The words are copied:
+ * the shell may modify them in place (trim_whitespace). */
+static char **cached_words(struct line_entry *e, size_t *nwords)
+{
+	char *w = amalloc(e->words_len);
+	char **tab = amalloc((e->nwords + 1) * sizeof(char *));
+
+	memcpy(w, e->buf + e->len, e->words_len);
+	for (size_t i = 0; i < e->nwords; i++) {
+		tab[i] = w;
+		w += strlen(w) + 1;
+	}
+	tab[e->nwords] = 0;
+	*nwords = e->nwords;
 	return tab;
 }
 
 
-static void freeseq(char ***seq)
+static void cache_words(struct line_entry *e, uint64_t h, const char *line,
+			size_t len, char **words, size_t nwords)
 {
-	int i, j;
+	size_t words_len = 0, pos;
+
+	for (size_t i = 0; i < nwords; i++)
+		words_len += strlen(words[i]) + 1;
+	if (len + words_len > e->cap) {
+		char *buf = realloc(e->buf, len + words_len);
+		stats.heap_calls++;
+		if (!buf)
+			return;	/* Not cached, the entry is left as it was */
+		e->buf = buf;
+		e->cap = len + words_len;
+	}
+	memcpy(e->buf, line, len);
+	pos = len;
+	for (size_t i = 0; i < nwords; i++) {
+		size_t l = strlen(words[i]) + 1;
+		memcpy(e->buf + pos, words[i], l);
+		pos += l;
+	}
+	e->hash = h;
+	e->len = len;
+	e->nwords = nwords;
+	e->words_len = words_len;
+	e->last_use = ++line_clock;
+}
 
-	for (i=0; seq[i]!=0; i++) {
-		char **cmd = seq[i];
 
-		for (j=0; cmd[j]!=0; j++) free(cmd[j]);
-		free(cmd);
+/* Words of the line, from the cache when it has been seen recently */
+static char **line_words(const char *line, size_t len, size_t *nwords)
+{
+	struct line_entry *victim = &line_cache[0];
+	uint64_t h;
+	char **words;
+
+	if (!line_cache_on || len == 0 || len > LINE_CACHE_MAX_LINE)
+		return split_in_words(line, len, nwords);
+
+	h = hash_line(line, len);
+	for (int i = 0; i < LINE_CACHE_SLOTS; i++) {
+		struct line_entry *e = &line_cache[i];
+		if (e->len == len && e->hash == h && memcmp(e->buf, line, len) == 0) {
+			stats.cache_hits++;
+			e->last_use = ++line_clock;
+			return cached_words(e, nwords);
+		}
+		if (e->last_use < victim->last_use)
+			victim = e;
 	}
-	free(seq);
+
+	stats.cache_misses++;
+	words = split_in_words(line, len, nwords);
+	cache_words(victim, h, line, len, words, *nwords);
+	return words;
 }
 
 
-/* Free the fields of the structure but not the structure itself */
-static void freecmd(struct cmdline *s)
+void readcmd_set_cache(int on)
 {
-	if (s->in) free(s->in);
-	if (s->out) free(s->out);
-	if (s->seq) freeseq(s->seq);
+	line_cache_on = on;
+	if (on)
+		return;
+	for (int i = 0; i < LINE_CACHE_SLOTS; i++) {
+		free(line_cache[i].buf);
+		memset(&line_cache[i], 0, sizeof(line_cache[i]));
+	}
+}
+
+
+int readcmd_cache_enabled(void)
+{
+	return line_cache_on;
+}
+
+
+void readcmd_get_stats(struct readcmd_stats *st)
+{
+	*st = stats;
+	st->heap_calls += line_arena.heap_calls;
+	st->arena_bytes = line_arena.capacity;
 }
 
 
@@ -252,43 +318,39 @@ struct cmdline *readcmd(void)
 {
 	static struct cmdline *static_cmdline = 0;
 	struct cmdline *s = static_cmdline;
-	char *line;
+	const char *line;
+	ssize_t len;
 	char **words;
-	int i;
+	size_t nwords, ncmds, i;
 	char *w;
 	char **cmd;
 	char ***seq;
 	size_t cmd_len, seq_len;
 
-	line = readline();
-	if (line == NULL) {
-		if (s) {
-			freecmd(s);
-			free(s);
-		}
+	len = input_readline(&line);
+	/* Frees everything the previous line allocated */
+	arena_reset(&line_arena);
+	if (len < 0) {
+		if (errno == ENOMEM) memory_error();
+		free(s);
+		arena_free(&line_arena);
 		return static_cmdline = 0;
 	}
+	stats.lines++;
 
-	cmd = xmalloc(sizeof(char *));
-	cmd[0] = 0;
-	cmd_len = 0;
-	seq = xmalloc(sizeof(char **));
-	seq[0] = 0;
-	seq_len = 0;
-
-	words = split_in_words(line);
-	free(line);
-	words = expand_globs(words);
+	words = line_words(line, len, &nwords);
+	words = expand_globs(words, nwords);
 	/* Expansion du tilde */
-	for (i = 0; words[i] != 0; i++) {
-		if (words[i][0] == '~')
-			words[i] = expand_tilde(words[i]);
+	for (nwords = 0; words[nwords] != 0; nwords++) {
+		if (words[nwords][0] == '~')
+			words[nwords] = expand_tilde(words[nwords]);
 	}
 
-	if (!s)
-		static_cmdline = s = xmalloc(sizeof(struct cmdline));
-	else
-		freecmd(s);
+	if (!s) {
+		static_cmdline = s = malloc(sizeof(struct cmdline));
+		if (!s) memory_error();
+		stats.heap_calls++;
+	}
 	s->err = 0;
 	s->in = 0;
 	s->out = 0;
@@ -296,6 +358,18 @@ struct cmdline *readcmd(void)
 	s->bg = 0;
 	s->seq = 0;
 
+	/* All commands share one array: each is a slice of it ended by a null
+	 * pointer, so there are at most nwords + ncmds entries */
+	ncmds = 1;
+	for (i = 0; i < nwords; i++)
+		if (words[i][0] == '|')
+			ncmds++;
+	cmd = amalloc((nwords + ncmds) * sizeof(char *));
+	seq = amalloc((ncmds + 1) * sizeof(char **));
+	cmd_len = 0;
+	seq_len = 0;
+	seq[0] = 0;
+
 	i = 0;
 	while ((w = words[i++]) != 0) {
 		switch (w[0]) {
@@ -336,58 +410,30 @@ struct cmdline *readcmd(void)
 				s->err = "misplaced pipe";
 				goto error;
 			}
-
-			seq = xrealloc(seq, (seq_len + 2) * sizeof(char **));
+			cmd[cmd_len] = 0;
 			seq[seq_len++] = cmd;
 			seq[seq_len] = 0;
-
-			cmd = xmalloc(sizeof(char *));
-			cmd[0] = 0;
+			cmd += cmd_len + 1;
 			cmd_len = 0;
 			break;
 		default:
-			cmd = xrealloc(cmd, (cmd_len + 2) * sizeof(char *));
 			cmd[cmd_len++] = w;
-			cmd[cmd_len] = 0;
 		}
 	}
 
 	if (cmd_len != 0) {
-		seq = xrealloc(seq, (seq_len + 2) * sizeof(char **));
+		cmd[cmd_len] = 0;
 		seq[seq_len++] = cmd;
 		seq[seq_len] = 0;
 	} else if (seq_len != 0) {
 		s->err = "misplaced pipe";
-		i--;
 		goto error;
-	} else
-		free(cmd);
-	free(words);
+	}
 	s->seq = seq;
 	return s;
 error:
-	while ((w = words[i++]) != 0) {
-		switch (w[0]) {
-		case '<':
-		case '>':
-		case '|':
-		case '&':
-			break;
-		default:
-			free(w);
-		}
-	}
-	free(words);
-	freeseq(seq);
-	for (i=0; cmd[i]!=0; i++) free(cmd[i]);
-	free(cmd);
-	if (s->in) {
-		free(s->in);
-		s->in = 0;
-	}
-	if (s->out) {
-		free(s->out);
-		s->out = 0;
-	}
+	/* The words stay in the arena until the next line */
+	s->in = 0;
+	s->out = 0;
 	return s;
 }
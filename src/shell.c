@@ -3,15 +3,33 @@
  * Copyright (C) 2002, Simon Nieuviarts (code original)
  */
 
+#define _GNU_SOURCE     // pipe2
+#include <errno.h>
+#include <limits.h>
+#include <poll.h>
+#include <spawn.h>
+#include <sys/syscall.h>
 #include "shell.h"
-#include "csapp.h"
+#include "eventloop.h"
+#include "pathcache.h"
+#include "loadable.h"
+#include "jobqueue.h"
+#include "priority.h"
 
 /* ============================================ */
 /* ========== Variables globales (jobs) ========== */
 /* ============================================ */
-job_t jobs[MAXJOBS];
 static int next_job_id = 1;
 
+int last_status = 0;
+volatile sig_atomic_t builtin_interrupted = 0;
+
+/* Options du shell, modifiables par la commande set */
+shell_options_t shell_opts = {
+    .spawn_mode = SPAWN_POSIX,
+    .interactive = 1,
+};
+
 
 /* ============================================ */
 /* ========== Table des commandes intégrées ========== */
@@ -19,26 +37,243 @@ static int next_job_id = 1;
 
 // Commandes intégrées : tout ce qui modifie le Shell (cd y est mais pas mkdir par exemple)
 builtin_cmd_t builtin_commands[] = {
-    {"quit", builtin_quit, "Quitte le shell"},
-    {"exit", builtin_exit, "Quitte le shell"},
+    {"quit", builtin_quit, "Quitte le shell (code de retour optionnel)"},
+    {"exit", builtin_exit, "Quitte le shell (code de retour optionnel)"},
     {"cd", builtin_cd, "Change de répertoire"},
     {"help", builtin_help, "Affiche l'aide"},
     {"jobs", builtin_jobs, "Liste les travaux en cours"},
     {"fg", builtin_fg, "Met un travail au premier plan"},
     {"bg", builtin_bg, "Relance un travail en arrière-plan"},
     {"stop", builtin_stop, "Arrête un travail"},
+    {"wait", builtin_wait, "Attend la fin de travaux en arrière-plan (-n : le premier qui finit)"},
+    {"prio", builtin_prio, "Priorité d'un travail en arrière-plan (prio off|batch|idle %n)"},
+    {"pin", builtin_pin, "Fixe les processeurs d'un travail (pin CPUS %n) ou d'une commande (pin CPUS cmd)"},
+    {"set", builtin_set, "Affiche ou modifie les options du shell"},
+    {"hash", builtin_hash, "Affiche ou vide le cache des chemins de commandes"},
+    {"parallel", builtin_parallel, "Lance une commande sur une liste d'entrées, N jobs à la fois (-j N)"},
+    {"enable", builtin_enable, "Charge une commande intégrée (enable -f lib.so nom)"},
+    {"echo", builtin_echo, "Affiche ses arguments", 1},
+    {"printf", builtin_printf, "Affiche selon un format", 1},
+    {"true", builtin_true, "Ne fait rien, avec succès", 1},
+    {"false", builtin_false, "Ne fait rien, avec échec", 1},
+    {"test", builtin_test, "Évalue une expression conditionnelle", 1},
+    {"[", builtin_test, "Évalue une expression conditionnelle", 1},
+    {"sleep", builtin_sleep, "Attend un certain temps", 1},
     {NULL, NULL, NULL}  // Sentinel
 };
 
 
 
+/* ============================================ */
+/* ========== Gestion des commandes intégrées ========== */
+/* ============================================ */
+
+// Toutes les commandes enregistrées (table statique puis chargées par enable),
+// dans l'ordre d'enregistrement, et index de hachage (adressage ouvert) sur
+// leurs noms : la recherche ne dépend pas du nombre de commandes.
+static builtin_cmd_t **builtin_list = NULL;
+static int builtin_count = 0;
+static int builtin_cap = 0;
+static builtin_cmd_t **builtin_index = NULL;
+static size_t builtin_index_size = 0;
+
+static size_t builtin_hash_name(const char *s) {
+    size_t h = 2166136261u;
+    while (*s) {
+        h ^= (unsigned char)*s++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static void builtin_index_insert(builtin_cmd_t *b) {
+    size_t i = builtin_hash_name(b->name) & (builtin_index_size - 1);
+    while (builtin_index[i] != NULL) {
+        i = (i + 1) & (builtin_index_size - 1);
+    }
+    builtin_index[i] = b;
+}
+
+// Reconstruit l'index (taux de remplissage <= 1/2)
+static void builtin_index_rebuild(void) {
+    size_t size = 32;
+    while (size < (size_t)builtin_count * 2) size *= 2;
+
+    builtin_cmd_t **idx = calloc(size, sizeof(builtin_cmd_t *));
+    if (idx == NULL) {
+        perror("calloc");
+        exit(1);
+    }
+    free(builtin_index);
+    builtin_index = idx;
+    builtin_index_size = size;
+    for (int i = 0; i < builtin_count; i++) {
+        builtin_index_insert(builtin_list[i]);
+    }
+}
+
+static void builtin_list_append(builtin_cmd_t *b) {
+    if (builtin_count == builtin_cap) {
+        builtin_cap = builtin_cap ? builtin_cap * 2 : 32;
+        builtin_list = realloc(builtin_list, builtin_cap * sizeof(builtin_cmd_t *));
+        if (builtin_list == NULL) {
+            perror("realloc");
+            exit(1);
+        }
+    }
+    builtin_list[builtin_count++] = b;
+}
+
+// Enregistre la table statique au premier usage
+static void init_builtins(void) {
+    if (builtin_index != NULL) return;
+    for (int i = 0; builtin_commands[i].name != NULL; i++) {
+        builtin_list_append(&builtin_commands[i]);
+    }
+    builtin_index_rebuild();
+}
+
+static int is_static_builtin(const builtin_cmd_t *b) {
+    size_t n = sizeof(builtin_commands) / sizeof(builtin_commands[0]);
+    return b >= builtin_commands && b < builtin_commands + n;
+}
+
+builtin_cmd_t *find_builtin(const char *name) {
+    init_builtins();
+    size_t i = builtin_hash_name(name) & (builtin_index_size - 1);
+    while (builtin_index[i] != NULL) {
+        if (strcmp(builtin_index[i]->name, name) == 0) {
+            return builtin_index[i];
+        }
+        i = (i + 1) & (builtin_index_size - 1);
+    }
+    return NULL;
+}
+
+int builtin_register(const char *name, int (*func)(char **args), const char *description) {
+    if (find_builtin(name) != NULL) {
+        return -1;  // Déjà défini
+    }
+
+    builtin_cmd_t *b = calloc(1, sizeof(builtin_cmd_t));
+    if (b == NULL) {
+        perror("calloc");
+        return -1;
+    }
+    b->name = (char *)name;
+    b->func = func;
+    b->description = (char *)(description ? description : "");
+    builtin_list_append(b);
+
+    if ((size_t)builtin_count * 2 > builtin_index_size) {
+        builtin_index_rebuild();
+    } else {
+        builtin_index_insert(b);
+    }
+    return 0;
+}
+
+int builtin_unregister(const char *name) {
+    builtin_cmd_t *b = find_builtin(name);
+    if (b == NULL || is_static_builtin(b)) {
+        return -1;  // Les commandes de la table statique restent
+    }
+
+    for (int i = 0; i < builtin_count; i++) {
+        if (builtin_list[i] == b) {
+            memmove(&builtin_list[i], &builtin_list[i + 1],
+                    (builtin_count - i - 1) * sizeof(builtin_cmd_t *));
+            builtin_count--;
+            break;
+        }
+    }
+    free(b);
+    builtin_index_rebuild();
+    return 0;
+}
+
+// Redirige stdin/stdout le temps de la commande intégrée, puis les restaure
+int run_builtin_redirected(builtin_cmd_t *b, char **cmd, char *input_file,
+                           char *output_file, int out_append) {
+    int saved_in = -1, saved_out = -1;
+    int status;
+
+    // Vider le tampon de stdout seulement s'il va changer de destination
+    if (output_file != NULL) fflush(stdout);
+    if (input_file != NULL) {
+        int fd = open(input_file, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            perror(input_file);
+            return 1;
+        }
+        saved_in = fcntl(STDIN_FILENO, F_DUPFD_CLOEXEC, 10);
+        dup2(fd, STDIN_FILENO);
+        close(fd);
+    }
+    if (output_file != NULL) {
+        int flags = O_WRONLY | O_CREAT | O_CLOEXEC;
+        flags |= out_append ? O_APPEND : O_TRUNC;
+        int fd = open(output_file, flags, 0644);
+        if (fd < 0) {
+            perror(output_file);
+            status = 1;
+            goto restore;
+        }
+        saved_out = fcntl(STDOUT_FILENO, F_DUPFD_CLOEXEC, 10);
+        dup2(fd, STDOUT_FILENO);
+        close(fd);
+    }
+
+    status = b->func(cmd);
+    if (output_file != NULL) fflush(stdout);
+
+restore:
+    if (saved_in >= 0) {
+        dup2(saved_in, STDIN_FILENO);
+        close(saved_in);
+    }
+    if (saved_out >= 0) {
+        dup2(saved_out, STDOUT_FILENO);
+        close(saved_out);
+    }
+    return status;
+}
+
+int try_execute_builtin(char **cmd) {
+    if (cmd == NULL || cmd[0] == NULL) {
+        return -1;  // Pas une commande intégrée
+    }
+
+    builtin_cmd_t *b = find_builtin(cmd[0]);
+    if (b != NULL) {
+        return b->func(cmd);
+    }
+
+    return -1;  // Pas une commande intégrée
+}
+
+
 /* ============================================ */
 /* ========== Implémentation des commandes intégrées (base) ========== */
 /* ============================================ */
+// quit [n] : sans argument, le code de retour est celui de la dernière commande
 int builtin_quit(char **args) {
-    printf(COL_VIOLET "À bientôt !" COL_RESET "\n");
-    exit(0);
-    return 0;
+    int status = last_status;
+    if (args[1] != NULL) {
+        char *end;
+        long v = strtol(args[1], &end, 10);
+        if (end == args[1] || *end != '\0') {
+            fprintf(stderr, COL_ROUGE "%s: %s: argument numérique requis" COL_RESET "\n", args[0], args[1]);
+            status = 2;
+        } else {
+            status = (int)(v & 0xff);
+        }
+    }
+    if (shell_opts.interactive) {
+        printf(COL_VIOLET "À bientôt !" COL_RESET "\n");
+    }
+    exit(status);
+    return status;
 }
 
 int builtin_exit(char **args) {
@@ -63,8 +298,9 @@ int builtin_cd(char **args) {
 
 int builtin_help(char **args) {
     printf(COL_VIOLET "Mini-shell" COL_RESET " - Commandes intégrées disponibles :\n");
-    for (int i = 0; builtin_commands[i].name != NULL; i++) {
-        printf("  " COL_ROSE "%-10s" COL_RESET " - %s\n", builtin_commands[i].name, builtin_commands[i].description);
+    init_builtins();
+    for (int i = 0; i < builtin_count; i++) {
+        printf("  " COL_ROSE "%-10s" COL_RESET " - %s\n", builtin_list[i]->name, builtin_list[i]->description);
     }
 
     printf("Les autres commandes ne sont pas intégrées\n");
@@ -73,22 +309,126 @@ int builtin_help(char **args) {
 
 
 
-/* ============================================ */
-/* ========== Gestion des commandes intégrées ========== */
-/* ============================================ */
-int try_execute_builtin(char **cmd) {
-    if (cmd == NULL || cmd[0] == NULL) {
-        return -1;  // Pas une commande intégrée
+// set : sans argument, affiche les options ; "set option valeur" les modifie
+int builtin_set(char **args) {
+    if (args[1] == NULL) {
+        printf(COL_BLEU "spawn" COL_RESET "\t%s\n",
+               shell_opts.spawn_mode == SPAWN_POSIX ? "posix_spawn" : "fork");
+        if (shell_opts.pipe_size > 0) {
+            printf(COL_BLEU "pipesize" COL_RESET "\t%d\n", shell_opts.pipe_size);
+        } else {
+            printf(COL_BLEU "pipesize" COL_RESET "\tdéfaut\n");
+        }
+        struct readcmd_stats st;
+        readcmd_get_stats(&st);
+        printf(COL_BLEU "linecache" COL_RESET "\t%s (%lu succès, %lu échecs)\n",
+               readcmd_cache_enabled() ? "on" : "off", st.cache_hits, st.cache_misses);
+        if (shell_opts.max_jobs > 0) {
+            printf(COL_BLEU "maxjobs" COL_RESET "\t\t%d\n", shell_opts.max_jobs);
+        } else {
+            printf(COL_BLEU "maxjobs" COL_RESET "\t\tillimité\n");
+        }
+        if (shell_opts.max_load > 0) {
+            printf(COL_BLEU "maxload" COL_RESET "\t\t%.2f\n", shell_opts.max_load);
+        } else {
+            printf(COL_BLEU "maxload" COL_RESET "\t\toff\n");
+        }
+        if (shell_opts.min_mem > 0) {
+            printf(COL_BLEU "minmem" COL_RESET "\t\t%ld Ko\n", shell_opts.min_mem / 1024);
+        } else {
+            printf(COL_BLEU "minmem" COL_RESET "\t\toff\n");
+        }
+        printf(COL_BLEU "bgprio" COL_RESET "\t\t%s\n", bgprio_name(shell_opts.bg_prio));
+        if (jobqueue_pending() > 0) {
+            printf(COL_BLEU "file" COL_RESET "\t\t%d jobs en attente\n", jobqueue_pending());
+        }
+        return 0;
     }
 
-    // Parcourir la table des commandes intégrées
-    for (int i = 0; builtin_commands[i].name != NULL; i++) {
-        if (strcmp(cmd[0], builtin_commands[i].name) == 0) {
-            return builtin_commands[i].func(cmd);
+    if (strcmp(args[1], "spawn") == 0) {
+        if (args[2] != NULL && strcmp(args[2], "posix_spawn") == 0) {
+            shell_opts.spawn_mode = SPAWN_POSIX;
+        } else if (args[2] != NULL && strcmp(args[2], "fork") == 0) {
+            shell_opts.spawn_mode = SPAWN_FORK;
+        } else {
+            fprintf(stderr, COL_ROUGE "set: spawn attend posix_spawn ou fork" COL_RESET "\n");
+            return 1;
         }
+        return 0;
     }
 
-    return -1;  // Pas une commande intégrée
+    // Capacité des pipes : octets, suffixes k/m acceptés, 0 = défaut du noyau
+    if (strcmp(args[1], "pipesize") == 0) {
+        long size = args[2] != NULL ? parse_size(args[2]) : -1;
+        if (size < 0 || size > INT_MAX) {
+            fprintf(stderr, COL_ROUGE "set: pipesize attend une taille (ex. 1M, 256k, 0)" COL_RESET "\n");
+            return 1;
+        }
+        shell_opts.pipe_size = (int)size;
+        return 0;
+    }
+
+    // Cache des lignes déjà découpées (scripts, boucles)
+    if (strcmp(args[1], "linecache") == 0) {
+        if (args[2] != NULL && strcmp(args[2], "on") == 0) {
+            readcmd_set_cache(1);
+        } else if (args[2] != NULL && strcmp(args[2], "off") == 0) {
+            readcmd_set_cache(0);
+        } else {
+            fprintf(stderr, COL_ROUGE "set: linecache attend on ou off" COL_RESET "\n");
+            return 1;
+        }
+        return 0;
+    }
+
+    // Admission des jobs en arrière-plan : au-delà, ils attendent en file.
+    // Une limite relevée fait partir aussitôt les jobs qu'elle retenait.
+    if (strcmp(args[1], "maxjobs") == 0) {
+        char *end = NULL;
+        long n = args[2] != NULL ? strtol(args[2], &end, 10) : -1;
+        if (end == args[2] || (end != NULL && *end != '\0') || n < 0 || n > INT_MAX) {
+            fprintf(stderr, COL_ROUGE "set: maxjobs attend un nombre de jobs (0 = illimité)" COL_RESET "\n");
+            return 1;
+        }
+        shell_opts.max_jobs = (int)n;
+        jobqueue_dispatch();
+        return 0;
+    }
+    if (strcmp(args[1], "maxload") == 0) {
+        char *end = NULL;
+        double load = args[2] != NULL ? strtod(args[2], &end) : -1;
+        if (end == args[2] || (end != NULL && *end != '\0') || !(load >= 0)) {
+            fprintf(stderr, COL_ROUGE "set: maxload attend une charge moyenne (ex. 4, 7.5, 0 = off)" COL_RESET "\n");
+            return 1;
+        }
+        shell_opts.max_load = load;
+        jobqueue_dispatch();
+        return 0;
+    }
+    if (strcmp(args[1], "minmem") == 0) {
+        long size = args[2] != NULL ? parse_size(args[2]) : -1;
+        if (size < 0) {
+            fprintf(stderr, COL_ROUGE "set: minmem attend une taille (ex. 512M, 0 = off)" COL_RESET "\n");
+            return 1;
+        }
+        shell_opts.min_mem = size;
+        jobqueue_dispatch();
+        return 0;
+    }
+
+    // Priorité des jobs lancés avec '&' (le préfixe "prio" la choisit par job)
+    if (strcmp(args[1], "bgprio") == 0) {
+        int prio = args[2] != NULL ? bgprio_parse(args[2]) : -1;
+        if (prio < 0) {
+            fprintf(stderr, COL_ROUGE "set: bgprio attend off, batch ou idle" COL_RESET "\n");
+            return 1;
+        }
+        shell_opts.bg_prio = prio;
+        return 0;
+    }
+
+    fprintf(stderr, COL_ROUGE "set: option inconnue: %s" COL_RESET "\n", args[1]);
+    return 1;
 }
 
 
@@ -99,6 +439,64 @@ void command_error(const char *cmd) {
     fprintf(stderr, COL_ROUGE "%s: command not found" COL_RESET "\n", cmd);
 }
 
+void print_prompt(void) {
+    printf(COL_VIOLET "Mini-shell >>> " COL_RESET);
+    fflush(stdout);
+}
+
+// Taille en octets avec suffixe optionnel k ou m (puissances de 1024).
+// Retourne -1 si la chaîne n'est pas une taille valide.
+long parse_size(const char *str) {
+    char *end;
+    errno = 0;
+    long v = strtol(str, &end, 10);
+    if (end == str || errno != 0 || v < 0) return -1;
+    if (*end == 'k' || *end == 'K') { v *= 1024; end++; }
+    else if (*end == 'm' || *end == 'M') { v *= 1024 * 1024; end++; }
+    return *end == '\0' ? v : -1;
+}
+
+// Liste de processeurs "0-3,6,8-11". Retourne 0, ou -1 si la liste est
+// invalide ou vide.
+int parse_cpu_list(const char *str, cpu_set_t *set) {
+    const char *p = str;
+    CPU_ZERO(set);
+    while (1) {
+        char *end;
+        long lo = strtol(p, &end, 10), hi = lo;
+        if (end == p || lo < 0) return -1;
+        p = end;
+        if (*p == '-') {
+            hi = strtol(p + 1, &end, 10);
+            if (end == p + 1 || hi < lo) return -1;
+            p = end;
+        }
+        if (hi >= CPU_SETSIZE) return -1;
+        for (long c = lo; c <= hi; c++) CPU_SET(c, set);
+        if (*p == '\0') break;
+        if (*p++ != ',') return -1;
+    }
+    return CPU_COUNT(set) > 0 ? 0 : -1;
+}
+
+// Forme inverse de parse_cpu_list : intervalles séparés par des virgules
+char *format_cpu_list(const cpu_set_t *set, char *buf, size_t size) {
+    size_t len = 0;
+    buf[0] = '\0';
+    for (int c = 0; c < CPU_SETSIZE && len < size; c++) {
+        if (!CPU_ISSET(c, set)) continue;
+        int hi = c;
+        while (hi + 1 < CPU_SETSIZE && CPU_ISSET(hi + 1, set)) hi++;
+        if (hi == c) {
+            len += snprintf(buf + len, size - len, "%s%d", len ? "," : "", c);
+        } else {
+            len += snprintf(buf + len, size - len, "%s%d-%d", len ? "," : "", c, hi);
+        }
+        c = hi;
+    }
+    return buf;
+}
+
 int count_commands(char ***seq) {
     int count = 0;
     while (seq[count] != NULL) {
@@ -160,77 +558,303 @@ void build_cmdline_str(struct cmdline *l, char *buf, size_t bufsize) {
 /* ============================================ */
 /* ========== Gestion des jobs ========== */
 /* ============================================ */
+
+// Table des jobs extensible :
+//  - job_list : jobs vivants, tableau compact (retrait par échange avec le dernier)
+//  - job_ids  : numéro de job -> job, numéros libérés réutilisés (le plus petit d'abord)
+//  - pid_index : table de hachage pid -> (job, rang dans le pipeline)
+// La structure (allocations, ajouts, retraits) n'est modifiée qu'en contexte
+// normal, signaux du shell bloqués. Le traitant SIGCHLD ne fait que des
+// recherches et des mises à jour de champs, sans allocation.
+
+typedef struct {
+    pid_t pid;                     // 0 = case vide, -1 = case supprimée
+    int slot;                      // Rang du processus dans job->pids
+    job_t *job;
+} pid_entry_t;
+
+#define PID_EMPTY   0
+#define PID_DELETED (-1)
+
+job_t **job_list = NULL;
+int num_jobs = 0;
+static int job_list_cap = 0;
+
+static job_t **job_ids = NULL;        // job_ids[id], id de 1 à job_ids_cap - 1
+static int job_ids_cap = 0;
+static int *free_ids = NULL;          // Tas min des numéros libérés
+static int num_free_ids = 0;
+
+static pid_entry_t *pid_index = NULL;
+static size_t pid_index_size = 0;     // Puissance de 2
+static size_t pid_index_used = 0;     // Cases occupées ou supprimées
+
+
+static void *xrealloc_jobs(void *ptr, size_t size) {
+    void *p = realloc(ptr, size);
+    if (p == NULL) {
+        perror("realloc");
+        exit(1);
+    }
+    return p;
+}
+
+// Bloque les signaux dont les traitants lisent ou modifient la table
+static void block_job_signals(sigset_t *prev) {
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGCHLD);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGTSTP);
+    sigprocmask(SIG_BLOCK, &mask, prev);
+}
+
+static size_t pid_hash(pid_t pid) {
+    return ((size_t)pid * 2654435761u) & (pid_index_size - 1);
+}
+
+static pid_entry_t *pid_index_find(pid_t pid) {
+    if (pid_index_size == 0) return NULL;
+    for (size_t i = pid_hash(pid); pid_index[i].pid != PID_EMPTY; i = (i + 1) & (pid_index_size - 1)) {
+        if (pid_index[i].pid == pid) return &pid_index[i];
+    }
+    return NULL;
+}
+
+static void pid_index_put(pid_t pid, job_t *job, int slot) {
+    // Un pid déjà présent ne peut être que le pgid d'un job terminé pas
+    // encore retiré : le nouveau processus le remplace
+    pid_entry_t *e = pid_index_find(pid);
+    if (e == NULL) {
+        size_t i = pid_hash(pid);
+        while (pid_index[i].pid > 0) i = (i + 1) & (pid_index_size - 1);
+        e = &pid_index[i];
+        if (e->pid == PID_EMPTY) pid_index_used++;
+        e->pid = pid;
+    }
+    e->slot = slot;
+    e->job = job;
+}
+
+static void pid_index_del(pid_t pid, job_t *job) {
+    pid_entry_t *e = pid_index_find(pid);
+    if (e != NULL && e->job == job) {
+        e->pid = PID_DELETED;
+        e->job = NULL;
+    }
+}
+
+// Redimensionne (et purge les cases supprimées) pour accueillir n pids de plus
+static void pid_index_reserve(size_t n) {
+    if ((pid_index_used + n) * 2 <= pid_index_size) return;
+
+    size_t live = 0;
+    for (size_t i = 0; i < pid_index_size; i++) {
+        if (pid_index[i].pid > 0) live++;
+    }
+    size_t size = 64;
+    while (size < (live + n) * 2) size *= 2;
+
+    pid_entry_t *old = pid_index;
+    size_t old_size = pid_index_size;
+    pid_index = calloc(size, sizeof(pid_entry_t));
+    if (pid_index == NULL) {
+        perror("calloc");
+        exit(1);
+    }
+    pid_index_size = size;
+    pid_index_used = 0;
+    for (size_t i = 0; i < old_size; i++) {
+        if (old[i].pid > 0) pid_index_put(old[i].pid, old[i].job, old[i].slot);
+    }
+    free(old);
+}
+
+// Numéros de job : tas min des numéros libérés, sinon le suivant.
+// Appelée aussi depuis le traitant SIGCHLD : job_ids a toujours assez de
+// place (un numéro attribué ne dépasse jamais le nombre de jobs vivants).
+static int alloc_job_id(job_t *j) {
+    int id;
+    if (num_free_ids > 0) {
+        id = free_ids[0];
+        int last = free_ids[--num_free_ids];
+        int i = 0;
+        while (2 * i + 1 < num_free_ids) {
+            int c = 2 * i + 1;
+            if (c + 1 < num_free_ids && free_ids[c + 1] < free_ids[c]) c++;
+            if (last <= free_ids[c]) break;
+            free_ids[i] = free_ids[c];
+            i = c;
+        }
+        if (num_free_ids > 0) free_ids[i] = last;
+    } else {
+        id = next_job_id++;
+    }
+    job_ids[id] = j;
+    return id;
+}
+
+static void release_job_id(int id) {
+    job_ids[id] = NULL;
+    int i = num_free_ids++;
+    while (i > 0 && free_ids[(i - 1) / 2] > id) {
+        free_ids[i] = free_ids[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    free_ids[i] = id;
+}
+
 void init_jobs(void) {
-    for (int i = 0; i < MAXJOBS; i++) {
-        jobs[i].id = 0;
-        jobs[i].pgid = 0;
-        jobs[i].num_procs = 0;
-        jobs[i].num_done = 0;
-        jobs[i].state = JOB_DONE;
-        jobs[i].bg = 0;
-        jobs[i].cmdline[0] = '\0';
+    sigset_t prev;
+    block_job_signals(&prev);
+    while (num_jobs > 0) {
+        remove_job(job_list[num_jobs - 1]);
     }
+    num_free_ids = 0;
     next_job_id = 1;
+    sigprocmask(SIG_SETMASK, &prev, NULL);
 }
 
-int add_job(pid_t pgid, pid_t *pids, int num_procs, job_state_t state, int bg, const char *cmdline) {
-    for (int i = 0; i < MAXJOBS; i++) {
-        if (jobs[i].pgid == 0) {
-            // Seuls les jobs en arrière-plan reçoivent un numéro visible
-            // Les jobs de premier plan reçoivent id=0 (invisible dans 'jobs')
-            // et recevront un id si stoppés par Ctrl+Z
-            jobs[i].id = bg ? next_job_id++ : 0;
-            jobs[i].pgid = pgid;
-            for (int j = 0; j < num_procs && j < MAX_PIPELINE; j++) {
-                jobs[i].pids[j] = pids[j];
-            }
-            jobs[i].num_procs = num_procs;
-            jobs[i].num_done = 0;
-            jobs[i].state = state;
-            jobs[i].bg = bg;
-            strncpy(jobs[i].cmdline, cmdline, sizeof(jobs[i].cmdline) - 1);
-            jobs[i].cmdline[sizeof(jobs[i].cmdline) - 1] = '\0';
-            return jobs[i].id;
+// Donne au job ses processus (pids) et les inscrit dans l'index.
+// Signaux du shell bloqués par l'appelant.
+// Les fils ne sont pas encore ramassés (SIGCHLD bloqué depuis leur
+// lancement) : le pid désigne bien le processus lancé.
+static int set_job_procs(job_t *j, pid_t pgid, pid_t *pids, int num_procs) {
+    pid_t *job_pids = NULL;
+    int *pidfds = NULL;
+    proc_usage_t *usage = NULL;
+    if (num_procs > 0) {
+        job_pids = malloc(num_procs * sizeof(pid_t));
+        pidfds = malloc(num_procs * sizeof(int));
+        usage = calloc(num_procs, sizeof(proc_usage_t));
+        if (job_pids == NULL || pidfds == NULL || usage == NULL) {
+            free(job_pids);
+            free(pidfds);
+            free(usage);
+            return -1;
         }
+        pid_index_reserve(num_procs);
     }
-    fprintf(stderr, COL_ROUGE "Erreur: trop de jobs" COL_RESET "\n");
-    return -1;
+
+    free(j->pids);
+    free(j->pidfds);
+    free(j->usage);
+    j->pgid = pgid;
+    j->pids = job_pids;
+    j->pidfds = pidfds;
+    j->usage = usage;
+    for (int i = 0; i < num_procs; i++) {
+        j->pids[i] = pids[i];
+        j->pidfds[i] = syscall(SYS_pidfd_open, pids[i], 0);  // O_CLOEXEC d'office
+        usage[i].pid = pids[i];
+        pid_index_put(pids[i], j, i);
+    }
+    j->num_procs = num_procs;
+    j->num_done = 0;
+    clock_gettime(CLOCK_MONOTONIC, &j->start);
+    j->end = j->start;
+    return 0;
 }
 
-void remove_job(pid_t pgid) {
-    for (int i = 0; i < MAXJOBS; i++) {
-        if (jobs[i].pgid == pgid) {
-            jobs[i].id = 0;
-            jobs[i].pgid = 0;
-            jobs[i].num_procs = 0;
-            jobs[i].num_done = 0;
-            jobs[i].state = JOB_DONE;
-            jobs[i].bg = 0;
-            jobs[i].cmdline[0] = '\0';
-            return;
-        }
+// Lance un job en file (JOB_QUEUED) : il garde son numéro
+static int attach_job_procs(job_t *j, pid_t pgid, pid_t *pids, int num_procs, int bg) {
+    sigset_t prev;
+    block_job_signals(&prev);
+    int ret = set_job_procs(j, pgid, pids, num_procs);
+    // Faute de mémoire, le job n'est plus suivi : il est signalé terminé
+    j->state = ret == 0 ? JOB_RUNNING : JOB_DONE;
+    j->status = ret == 0 ? 0 : 1;
+    j->bg = bg;
+    sigprocmask(SIG_SETMASK, &prev, NULL);
+    return ret;
+}
+
+int add_job(pid_t pgid, pid_t *pids, int num_procs, job_state_t state, int bg, const char *cmdline) {
+    sigset_t prev;
+    block_job_signals(&prev);
+
+    job_t *j = calloc(1, sizeof(job_t));
+    char *cmd = strdup(cmdline);
+    if (j == NULL || cmd == NULL || set_job_procs(j, pgid, pids, num_procs) != 0) {
+        free(j);
+        free(cmd);
+        fprintf(stderr, COL_ROUGE "Erreur: trop de jobs" COL_RESET "\n");
+        sigprocmask(SIG_SETMASK, &prev, NULL);
+        return -1;
     }
+
+    // Réserver toute la place nécessaire avant que le job soit visible
+    if (num_jobs == job_list_cap) {
+        job_list_cap = job_list_cap ? job_list_cap * 2 : 16;
+        job_list = xrealloc_jobs(job_list, job_list_cap * sizeof(job_t *));
+        job_ids = xrealloc_jobs(job_ids, (job_list_cap + 1) * sizeof(job_t *));
+        for (int i = job_ids_cap; i <= job_list_cap; i++) job_ids[i] = NULL;
+        job_ids_cap = job_list_cap + 1;
+        free_ids = xrealloc_jobs(free_ids, job_ids_cap * sizeof(int));
+    }
+
+    // Seuls les jobs en arrière-plan reçoivent un numéro visible
+    // Les jobs de premier plan reçoivent id=0 (invisible dans 'jobs')
+    // et recevront un id si stoppés par Ctrl+Z
+    j->slot = num_jobs;
+    job_list[num_jobs++] = j;
+    j->id = bg ? alloc_job_id(j) : 0;
+    j->status = 0;
+    j->state = state;
+    j->bg = bg;
+    j->cmdline = cmd;
+
+    sigprocmask(SIG_SETMASK, &prev, NULL);
+    return j->id;
 }
 
-job_t *find_job_by_pid(pid_t pgid) {
-    for (int i = 0; i < MAXJOBS; i++) {
-        if (jobs[i].pgid == pgid) return &jobs[i];
+void remove_job(job_t *j) {
+    sigset_t prev;
+    block_job_signals(&prev);
+
+    for (int i = 0; i < j->num_procs; i++) {
+        if (j->pids[i] != 0) pid_index_del(j->pids[i], j);
+        if (j->pidfds[i] >= 0) close(j->pidfds[i]);
     }
-    return NULL;
+    pid_index_del(j->pgid, j);
+    if (j->id > 0) release_job_id(j->id);
+
+    // Retrait en O(1) : le dernier job prend la place libérée
+    job_t *last = job_list[--num_jobs];
+    job_list[j->slot] = last;
+    last->slot = j->slot;
+
+    // Table vide : les numéros repartent de 1
+    if (num_jobs == 0) {
+        num_free_ids = 0;
+        next_job_id = 1;
+    }
+    sigprocmask(SIG_SETMASK, &prev, NULL);
+
+    free(j->cmdline);
+    free(j->pids);
+    free(j->pidfds);
+    free(j->usage);
+    free(j->queued);
+    free(j);
+}
+
+// Recherche par PID d'un processus du job (en particulier le pgid)
+job_t *find_job_by_pid(pid_t pid) {
+    pid_entry_t *e = pid_index_find(pid);
+    return e != NULL ? e->job : NULL;
 }
 
 job_t *find_job_by_id(int id) {
-    for (int i = 0; i < MAXJOBS; i++) {
-        if (jobs[i].id == id && jobs[i].pgid != 0) return &jobs[i];
-    }
-    return NULL;
+    if (id <= 0 || id >= job_ids_cap) return NULL;
+    return job_ids[id];
 }
 
 // Trouve le job de premier plan actif
 job_t *get_fg_job(void) {
-    for (int i = 0; i < MAXJOBS; i++) {
-        if (jobs[i].pgid != 0 && !jobs[i].bg && jobs[i].state == JOB_RUNNING) {
-            return &jobs[i];
+    for (int i = 0; i < num_jobs; i++) {
+        if (!job_list[i]->bg && job_list[i]->state == JOB_RUNNING) {
+            return job_list[i];
         }
     }
     return NULL;
@@ -240,15 +864,11 @@ job_t *get_fg_job(void) {
 job_t *parse_job_ref(const char *ref) {
     if (ref == NULL) {
         // Sans argument : dernier job (plus grand id)
-        job_t *last = NULL;
-        for (int i = 0; i < MAXJOBS; i++) {
-            if (jobs[i].pgid != 0) {
-                if (last == NULL || jobs[i].id > last->id) {
-                    last = &jobs[i];
-                }
-            }
+        for (int id = next_job_id - 1; id > 0; id--) {
+            if (job_ids[id] != NULL) return job_ids[id];
         }
-        return last;
+        // Sinon un job sans numéro (premier plan)
+        return num_jobs > 0 ? job_list[num_jobs - 1] : NULL;
     }
     if (ref[0] == '%') {
         int id = atoi(ref + 1);
@@ -259,25 +879,142 @@ job_t *parse_job_ref(const char *ref) {
     }
 }
 
+#ifndef PIDFD_SIGNAL_PROCESS_GROUP
+#define PIDFD_SIGNAL_PROCESS_GROUP (1U << 2)   // Linux 6.9
+#endif
+
+// Tant qu'un processus du job n'est pas ramassé, son pidfd le désigne sans
+// ambiguïté et le pgid ne peut pas être réattribué. Appelée aussi depuis
+// les traitants SIGINT/SIGTSTP : rien que des appels système.
+int job_signal(job_t *j, int sig) {
+    for (int i = 0; i < j->num_procs; i++) {
+        if (j->pidfds[i] < 0) continue;
+        if (syscall(SYS_pidfd_send_signal, j->pidfds[i], sig, NULL,
+                    PIDFD_SIGNAL_PROCESS_GROUP) == 0) {
+            return 0;
+        }
+        if (errno != EINVAL) return -1;
+        break;  // Noyau sans envoi au groupe par pidfd : kill(-pgid)
+    }
+    if (j->num_procs == 0 || j->num_done >= j->num_procs) {
+        errno = ESRCH;  // Job en file ou déjà terminé : plus de groupe
+        return -1;
+    }
+    return kill(-j->pgid, sig);
+}
+
 const char *job_state_str(job_state_t state) {
     switch (state) {
         case JOB_RUNNING: return "Running";
         case JOB_STOPPED: return "Stopped";
         case JOB_DONE:    return "Done";
+        case JOB_QUEUED:  return "Queued";
         default: return "Unknown";
     }
 }
 
-// Vérifie et affiche les jobs en arrière-plan terminés
-void check_completed_bg_jobs(void) {
-    for (int i = 0; i < MAXJOBS; i++) {
-        if (jobs[i].pgid != 0 && jobs[i].id > 0 && jobs[i].bg && jobs[i].state == JOB_DONE) {
-            printf(COL_CYAN "[%d]" COL_RESET " " COL_VERT "Done" COL_RESET "\t\t" COL_ROSE "%s" COL_RESET "\n", jobs[i].id, jobs[i].cmdline);
-            remove_job(jobs[i].pgid);
+/* ========== Consommation des jobs (wait4) ========== */
+
+static double timespec_diff(struct timespec a, struct timespec b) {
+    return (b.tv_sec - a.tv_sec) + (b.tv_nsec - a.tv_nsec) / 1e9;
+}
+
+static double timeval_sec(struct timeval tv) {
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+// Une ligne de mesures : réel, CPU utilisateur et système, RSS max (Ko),
+// changements de contexte volontaires / involontaires
+static void print_usage_line(FILE *out, double real, const struct rusage *ru) {
+    fprintf(out, "réel %.3fs  user %.3fs  sys %.3fs  rss max %ld Ko  ctx %ld/%ld\n",
+            real, timeval_sec(ru->ru_utime), timeval_sec(ru->ru_stime),
+            ru->ru_maxrss, ru->ru_nvcsw, ru->ru_nivcsw);
+}
+
+// Temps et ressources d'un job : le total (CPU additionné, RSS du plus gros
+// processus), puis une ligne par étape si c'est un pipeline. Le temps réel
+// d'une étape court du lancement du job jusqu'à sa fin. Tant qu'une étape
+// tourne, le total n'est pas connu : seule la durée écoulée est donnée.
+void print_job_usage(job_t *j, FILE *out, const char *indent) {
+    struct timespec now;
+    struct rusage total;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    memset(&total, 0, sizeof(total));
+
+    if (j->num_done < j->num_procs) {
+        fprintf(out, "%sen cours depuis %.3fs\n", indent, timespec_diff(j->start, now));
+    } else {
+        for (int i = 0; i < j->num_procs; i++) {
+            const struct rusage *ru = &j->usage[i].ru;
+            timeradd(&total.ru_utime, &ru->ru_utime, &total.ru_utime);
+            timeradd(&total.ru_stime, &ru->ru_stime, &total.ru_stime);
+            if (ru->ru_maxrss > total.ru_maxrss) total.ru_maxrss = ru->ru_maxrss;
+            total.ru_nvcsw += ru->ru_nvcsw;
+            total.ru_nivcsw += ru->ru_nivcsw;
+        }
+        fprintf(out, "%s", indent);
+        print_usage_line(out, timespec_diff(j->start, j->end), &total);
+    }
+
+    if (j->num_procs == 1) return;
+
+    // Nom de chaque étape, repris de la ligne de commande affichée
+    char names[256];
+    char *stage = names, *sep;
+    snprintf(names, sizeof(names), "%s", j->cmdline);
+    for (int i = 0; i < j->num_procs; i++) {
+        if (stage != NULL && (sep = strstr(stage, " | ")) != NULL) *sep = '\0';
+        fprintf(out, "%s  %d. %-16.16s pid %-7d ", indent, i + 1, stage ? stage : "", j->usage[i].pid);
+        if (j->usage[i].done) {
+            print_usage_line(out, timespec_diff(j->start, j->usage[i].end), &j->usage[i].ru);
+        } else {
+            fprintf(out, "en cours depuis %.3fs\n", timespec_diff(j->start, now));
+        }
+        stage = stage != NULL && sep != NULL ? sep + 3 : NULL;
+    }
+}
+
+// Nombre de jobs en arrière-plan terminés pas encore signalés
+int pending_bg_notifications(void) {
+    int count = 0;
+    for (int i = 0; i < num_jobs; i++) {
+        if (job_list[i]->id > 0 && job_list[i]->bg && job_list[i]->state == JOB_DONE) {
+            count++;
+        }
+    }
+    return count;
+}
+
+// Vérifie et affiche les jobs en arrière-plan terminés (par ordre de numéro)
+int check_completed_bg_jobs(void) {
+    int notified = 0;
+    for (int id = 1; id < next_job_id; id++) {
+        job_t *j = job_ids[id];
+        if (j != NULL && j->bg && j->state == JOB_DONE) {
+            printf(COL_CYAN "[%d]" COL_RESET " " COL_VERT "Done" COL_RESET "\t\t" COL_ROSE "%s" COL_RESET "\n", j->id, j->cmdline);
+            if (j->timed) {
+                fflush(stdout);
+                print_job_usage(j, stderr, "");
+            }
+            remove_job(j);
+            notified++;
         }
-        // Nettoyer silencieusement les jobs fg terminés (id == 0)
-        if (jobs[i].pgid != 0 && jobs[i].id == 0 && jobs[i].state == JOB_DONE) {
-            remove_job(jobs[i].pgid);
+    }
+    // Nettoyer silencieusement les jobs fg terminés (id == 0)
+    for (int i = num_jobs - 1; i >= 0; i--) {
+        if (job_list[i]->id == 0 && job_list[i]->state == JOB_DONE) {
+            remove_job(job_list[i]);
+        }
+    }
+    return notified;
+}
+
+// Mode script : retire les jobs terminés sans rien afficher (sauf "time")
+void discard_completed_jobs(void) {
+    for (int i = num_jobs - 1; i >= 0; i--) {
+        if (job_list[i]->state == JOB_DONE) {
+            if (job_list[i]->timed) print_job_usage(job_list[i], stderr, "");
+            remove_job(job_list[i]);
         }
     }
 }
@@ -287,43 +1024,62 @@ void check_completed_bg_jobs(void) {
 /* ========== Traitants de signaux ========== */
 /* ============================================ */
 
-// SIGCHLD : ramasser les processus fils terminés ou stoppés
-void sigchld_handler(int sig) {
-    int saved_errno = errno;
+// Ramasse tous les fils terminés ou stoppés et met à jour la table des jobs.
+// Appelée depuis le traitant SIGCHLD, ou en contexte normal par la boucle
+// d'événements : une seule passe traite toutes les terminaisons en attente.
+// wait4 rend aussi la consommation du fils, gardée dans son job.
+void reap_children(void) {
     int status;
     pid_t pid;
-
-    while ((pid = waitpid(-1, &status, WNOHANG | WUNTRACED)) > 0) {
-        // Trouver le job correspondant à ce PID
-        for (int i = 0; i < MAXJOBS; i++) {
-            if (jobs[i].pgid == 0) continue;
-            int found = 0;
-            for (int j = 0; j < jobs[i].num_procs; j++) {
-                if (jobs[i].pids[j] == pid) {
-                    if (WIFEXITED(status) || WIFSIGNALED(status)) {
-                        // Processus terminé (normalement ou par signal)
-                        jobs[i].pids[j] = 0;
-                        jobs[i].num_done++;
-                        if (jobs[i].num_done >= jobs[i].num_procs) {
-                            jobs[i].state = JOB_DONE;
-                        }
-                    } else if (WIFSTOPPED(status)) {
-                        // Processus stoppé (Ctrl+Z / SIGTSTP)
-                        jobs[i].state = JOB_STOPPED;
-                        jobs[i].bg = 1;  // Passe en arrière-plan
-                        // Attribuer un numéro de job s'il n'en avait pas (fg stoppé)
-                        if (jobs[i].id == 0) {
-                            jobs[i].id = next_job_id++;
-                        }
-                    }
-                    found = 1;
-                    break;
-                }
+    struct rusage ru;
+
+    while ((pid = wait4(-1, &status, WNOHANG | WUNTRACED, &ru)) > 0) {
+        // Trouver le job correspondant à ce PID (table de hachage)
+        pid_entry_t *e = pid_index_find(pid);
+        if (e == NULL) continue;
+        job_t *j = e->job;
+        int slot = e->slot;
+
+        if (WIFEXITED(status) || WIFSIGNALED(status)) {
+            // Processus terminé (normalement ou par signal)
+            if (slot == j->num_procs - 1) {
+                j->status = WIFEXITED(status) ? WEXITSTATUS(status)
+                                              : 128 + WTERMSIG(status);
+            }
+            j->pids[slot] = 0;
+            if (j->pidfds[slot] >= 0) {
+                close(j->pidfds[slot]);
+                j->pidfds[slot] = -1;
+            }
+            j->usage[slot].done = 1;
+            j->usage[slot].ru = ru;
+            clock_gettime(CLOCK_MONOTONIC, &j->usage[slot].end);
+            j->end = j->usage[slot].end;
+            // L'entrée du pgid reste jusqu'au retrait du job (fg, jobs, wait...)
+            if (pid != j->pgid) {
+                e->pid = PID_DELETED;
+                e->job = NULL;
+            }
+            j->num_done++;
+            if (j->num_done >= j->num_procs) {
+                j->state = JOB_DONE;
+            }
+        } else if (WIFSTOPPED(status)) {
+            // Processus stoppé (Ctrl+Z / SIGTSTP)
+            j->state = JOB_STOPPED;
+            j->bg = 1;  // Passe en arrière-plan
+            // Attribuer un numéro de job s'il n'en avait pas (fg stoppé)
+            if (j->id == 0) {
+                j->id = alloc_job_id(j);
             }
-            if (found) break;
         }
     }
+}
 
+// SIGCHLD : ramasser les processus fils terminés ou stoppés
+void sigchld_handler(int sig) {
+    int saved_errno = errno;
+    reap_children();
     errno = saved_errno;
 }
 
@@ -331,7 +1087,9 @@ void sigchld_handler(int sig) {
 void sigint_handler(int sig) {
     job_t *fg = get_fg_job();
     if (fg != NULL) {
-        kill(-fg->pgid, SIGINT);
+        job_signal(fg, SIGINT);
+    } else {
+        builtin_interrupted = SIGINT;  // Interrompt une commande intégrée (sleep)
     }
 }
 
@@ -339,7 +1097,9 @@ void sigint_handler(int sig) {
 void sigtstp_handler(int sig) {
     job_t *fg = get_fg_job();
     if (fg != NULL) {
-        kill(-fg->pgid, SIGTSTP);
+        job_signal(fg, SIGTSTP);
+    } else {
+        builtin_interrupted = SIGTSTP;  // Suspend une commande intégrée (sleep)
     }
 }
 
@@ -348,24 +1108,79 @@ void sigtstp_handler(int sig) {
 /* ========== Commandes intégrées (jobs) ========== */
 /* ============================================ */
 
+// Affinité courante des processus vivants du job : une seule liste si tous
+// ont la même, sinon celle de chaque pid
+static void print_job_cpus(job_t *j) {
+    cpu_set_t first, set;
+    char buf[256];
+    int n = 0, same = 1;
+
+    for (int i = 0; i < j->num_procs; i++) {
+        if (j->pids[i] == 0 || sched_getaffinity(j->pids[i], sizeof(set), &set) < 0) continue;
+        if (n++ == 0) first = set;
+        else if (!CPU_EQUAL(&set, &first)) same = 0;
+    }
+    if (n == 0) return;
+    if (same) {
+        printf("      cpus : %s\n", format_cpu_list(&first, buf, sizeof(buf)));
+        return;
+    }
+    printf("      cpus :");
+    for (int i = 0; i < j->num_procs; i++) {
+        if (j->pids[i] == 0 || sched_getaffinity(j->pids[i], sizeof(set), &set) < 0) continue;
+        printf(" %d=%s", j->pids[i], format_cpu_list(&set, buf, sizeof(buf)));
+    }
+    printf("\n");
+}
+
 // jobs : liste tous les travaux en cours
+// jobs -l : affiche aussi les détails de chaque job (pids, capacité des pipes,
+//           temps et ressources des processus terminés)
 int builtin_jobs(char **args) {
-    for (int i = 0; i < MAXJOBS; i++) {
-        if (jobs[i].pgid != 0 && jobs[i].id > 0) {
-            const char *state_col = jobs[i].state == JOB_STOPPED ? COL_JAUNE :
-                                    jobs[i].state == JOB_RUNNING ? COL_VERT : COL_VERT;
+    int details = args[1] != NULL && strcmp(args[1], "-l") == 0;
+
+    for (int id = 1; id < next_job_id; id++) {
+        job_t *j = job_ids[id];
+        if (j != NULL) {
+            const char *state_col = j->state == JOB_STOPPED ? COL_JAUNE :
+                                    j->state == JOB_QUEUED ? COL_BLEU : COL_VERT;
+            if (j->state == JOB_QUEUED) {
+                // Pas encore de processus
+                printf(COL_CYAN "[%d]" COL_RESET " - %s%s" COL_RESET "\t" COL_ROSE "%s" COL_RESET "\n",
+                       j->id, state_col, job_state_str(j->state), j->cmdline);
+                continue;
+            }
             printf(COL_CYAN "[%d]" COL_RESET " %d %s%s" COL_RESET "\t" COL_ROSE "%s" COL_RESET "\n",
-                   jobs[i].id, jobs[i].pgid, state_col,
-                   job_state_str(jobs[i].state), jobs[i].cmdline);
-            if (jobs[i].state == JOB_DONE) {
-                remove_job(jobs[i].pgid);
+                   j->id, j->pgid, state_col,
+                   job_state_str(j->state), j->cmdline);
+            if (details) {
+                printf("      processus :");
+                for (int i = 0; i < j->num_procs; i++) {
+                    if (j->pids[i] != 0) printf(" %d", j->pids[i]);
+                }
+                printf(" (%d/%d terminés)\n", j->num_done, j->num_procs);
+                if (j->pipe_size > 0) {
+                    printf("      pipes : %d octets\n", j->pipe_size);
+                }
+                print_job_cpus(j);
+                for (int i = 0; j->prio != BGPRIO_OFF && i < j->num_procs; i++) {
+                    char buf[128];
+                    if (j->pids[i] == 0) continue;
+                    printf("      priorité : %s (%s)\n", bgprio_name(j->prio),
+                           prio_describe(j->pids[i], buf, sizeof(buf)));
+                    break;
+                }
+                print_job_usage(j, stdout, "      ");
+            }
+            if (j->state == JOB_DONE) {
+                remove_job(j);
             }
         }
     }
     return 0;
 }
 
-// fg : mettre un travail au premier plan
+// fg : mettre un travail au premier plan (un job en file est lancé aussitôt)
 int builtin_fg(char **args) {
     job_t *j = parse_job_ref(args[1]);
     if (j == NULL) {
@@ -374,16 +1189,23 @@ int builtin_fg(char **args) {
     }
 
     printf(COL_ROSE "%s" COL_RESET "\n", j->cmdline);
+    if (j->state == JOB_QUEUED) {
+        jobqueue_start(j, 0);
+        return 0;
+    }
+    // Priorité du shell rendue avant la reprise
+    if (j->prio != BGPRIO_OFF) job_set_prio(j, 0, "fg");
     j->bg = 0;
     j->state = JOB_RUNNING;
-    kill(-j->pgid, SIGCONT);
+    job_signal(j, SIGCONT);
 
     // Attendre le job au premier plan
     wait_for_fg_job(j);
     return 0;
 }
 
-// bg : relancer un travail stoppé en arrière-plan
+// bg : relancer un travail stoppé en arrière-plan, ou lancer un job en file
+// sans attendre qu'une place se libère
 int builtin_bg(char **args) {
     job_t *j = parse_job_ref(args[1]);
     if (j == NULL) {
@@ -391,10 +1213,16 @@ int builtin_bg(char **args) {
         return 1;
     }
 
+    if (j->state == JOB_QUEUED) {
+        printf(COL_CYAN "[%d]" COL_RESET " " COL_ROSE "%s" COL_RESET " &\n", j->id, j->cmdline);
+        jobqueue_start(j, 1);
+        return 0;
+    }
     j->bg = 1;
     j->state = JOB_RUNNING;
     printf(COL_CYAN "[%d]" COL_RESET " " COL_ROSE "%s" COL_RESET " &\n", j->id, j->cmdline);
-    kill(-j->pgid, SIGCONT);
+    if (j->prio != BGPRIO_OFF) job_set_prio(j, 1, "bg");
+    job_signal(j, SIGCONT);
 
     return 0;
 }
@@ -406,12 +1234,181 @@ int builtin_stop(char **args) {
         fprintf(stderr, COL_ROUGE "stop: aucun travail correspondant" COL_RESET "\n");
         return 1;
     }
+    if (j->state == JOB_QUEUED) {
+        // Pas encore de processus à arrêter
+        fprintf(stderr, COL_ROUGE "stop: le travail [%d] est en file d'attente" COL_RESET "\n", j->id);
+        return 1;
+    }
 
-    kill(-j->pgid, SIGSTOP);
+    job_signal(j, SIGSTOP);
     return 0;
 }
 
 
+// pin : affiche l'affinité du shell
+// pin CPUS %n [%m...] : change celle de tous les processus vivants des jobs
+// (la forme "pin CPUS commande" est un préfixe de pipeline)
+int builtin_pin(char **args) {
+    cpu_set_t set;
+    char buf[256];
+
+    if (args[1] == NULL) {
+        if (sched_getaffinity(0, sizeof(set), &set) < 0) {
+            perror("pin");
+            return 1;
+        }
+        printf("shell : %s\n", format_cpu_list(&set, buf, sizeof(buf)));
+        return 0;
+    }
+    if (parse_cpu_list(args[1], &set) < 0 || args[2] == NULL) {
+        fprintf(stderr, COL_ROUGE "usage: pin CPUS %%n... | pin CPUS commande [| commande...]" COL_RESET "\n");
+        return 2;
+    }
+
+    int status = 0;
+    for (int k = 2; args[k] != NULL; k++) {
+        job_t *j = parse_job_ref(args[k]);
+        if (j == NULL) {
+            fprintf(stderr, COL_ROUGE "pin: %s: aucun travail correspondant" COL_RESET "\n", args[k]);
+            status = 1;
+            continue;
+        }
+        if (j->state == JOB_QUEUED) {
+            fprintf(stderr, COL_ROUGE "pin: le travail [%d] est en file d'attente" COL_RESET "\n", j->id);
+            status = 1;
+            continue;
+        }
+        // Un processus ramassé entre-temps (ESRCH) n'est pas une erreur
+        for (int i = 0; i < j->num_procs; i++) {
+            if (j->pids[i] != 0 && sched_setaffinity(j->pids[i], sizeof(set), &set) < 0 &&
+                errno != ESRCH) {
+                fprintf(stderr, COL_ROUGE "pin: %d: %s" COL_RESET "\n", j->pids[i], strerror(errno));
+                status = 1;
+            }
+        }
+    }
+    return status;
+}
+
+// Retire un job attendu par wait, sans message "Done"
+static void collect_waited_job(job_t *j) {
+    if (j->timed) {
+        fflush(stdout);
+        print_job_usage(j, stderr, "");
+    }
+    remove_job(j);
+}
+
+// wait [%n|pid ...] : attend la fin des jobs désignés, par défaut de tous les
+// jobs en arrière-plan ; le code de retour est celui du dernier désigné.
+// wait -n [...] : rend la main dès que l'un d'eux se termine, avec son code.
+// Un seul poll surveille les pidfds de tous les processus attendus ; un job
+// stoppé n'est plus attendu. Ctrl+C interrompt l'attente (code 130).
+int builtin_wait(char **args) {
+    int any = 0, k = 1;
+    if (args[k] != NULL && strcmp(args[k], "-n") == 0) {
+        any = 1;
+        k++;
+    }
+
+    // Jobs attendus, par numéro : seul wait retire des jobs pendant l'attente
+    int cap = args[k] != NULL ? 0 : num_jobs;
+    for (int i = k; args[i] != NULL; i++) cap++;
+    int *ids = malloc((cap + 1) * sizeof(int));
+    int nids = 0, status = 0;
+    if (ids == NULL) {
+        perror("malloc");
+        return 1;
+    }
+    if (args[k] == NULL) {
+        for (int id = 1; id < next_job_id; id++) {
+            job_t *j = job_ids[id];
+            if (j != NULL && (j->state == JOB_RUNNING || j->state == JOB_QUEUED)) ids[nids++] = id;
+        }
+    } else {
+        for (int i = k; args[i] != NULL; i++) {
+            job_t *j = parse_job_ref(args[i]);
+            if (j == NULL || j->id == 0) {
+                fprintf(stderr, COL_ROUGE "wait: %s: aucun travail correspondant" COL_RESET "\n", args[i]);
+                status = 127;
+                continue;
+            }
+            ids[nids++] = j->id;
+        }
+    }
+    if (any && nids == 0) {
+        free(ids);
+        return 127;
+    }
+
+    sigset_t mask_chld, prev_mask, wait_mask;
+    sigemptyset(&mask_chld);
+    sigaddset(&mask_chld, SIGCHLD);
+    sigprocmask(SIG_BLOCK, &mask_chld, &prev_mask);
+    wait_mask = prev_mask;
+    sigdelset(&wait_mask, SIGCHLD);
+
+    struct pollfd *pfds = NULL;
+    int pfds_cap = 0, interrupted = 0;
+    builtin_interrupted = 0;
+    while (1) {
+        // Ramassage en contexte normal, SIGCHLD bloqué
+        if (evloop_enabled()) {
+            evloop_reap();
+        } else {
+            reap_children();
+            jobqueue_dispatch();
+        }
+
+        int waiting = 0, nfds = 0, finished = 0;
+        for (int i = 0; i < nids; i++) {
+            if (ids[i] == 0) continue;  // Déjà terminé
+            job_t *j = find_job_by_id(ids[i]);
+            if (j == NULL || j->state == JOB_DONE || j->state == JOB_STOPPED) {
+                status = j == NULL ? 127 : j->state == JOB_DONE ? j->status : 128 + SIGTSTP;
+                if (j != NULL && j->state == JOB_DONE) collect_waited_job(j);
+                ids[i] = 0;
+                finished = 1;
+                continue;
+            }
+            waiting++;
+            if (nfds + j->num_procs + 1 > pfds_cap) {
+                pfds_cap = (nfds + j->num_procs + 1) * 2;
+                pfds = xrealloc_jobs(pfds, pfds_cap * sizeof(struct pollfd));
+            }
+            for (int p = 0; p < j->num_procs; p++) {
+                if (j->pidfds[p] < 0) continue;
+                pfds[nfds].fd = j->pidfds[p];
+                pfds[nfds].events = POLLIN;
+                nfds++;
+            }
+        }
+        if (waiting == 0 || (any && finished)) break;
+
+        // Un job en file n'a pas encore de pidfd et un arrêt ne rend pas le
+        // pidfd lisible : SIGCHLD réveille aussi l'attente (par le signalfd
+        // en mode événementiel, sinon par le traitant, débloqué le temps du poll)
+        if (evloop_enabled()) {
+            pfds[nfds].fd = evloop_child_fd();
+            pfds[nfds].events = POLLIN;
+            nfds++;
+        }
+        if (ppoll(pfds, nfds, NULL, &wait_mask) < 0 && errno == EINTR &&
+            builtin_interrupted == SIGINT) {
+            builtin_interrupted = 0;
+            interrupted = 1;
+            break;
+        }
+    }
+    sigprocmask(SIG_SETMASK, &prev_mask, NULL);
+
+    free(pfds);
+    free(ids);
+    if (interrupted) return 128 + SIGINT;
+    return args[k] == NULL && !any ? 0 : status;
+}
+
+
 /* ============================================ */
 /* ========== Gestion des redirections ========== */
 /* ============================================ */
@@ -472,160 +1469,525 @@ void execute_simple_command(char **cmd, char *input_file, char *output_file, int
     }
 }
 
-// Attendre un job de premier plan (boucle avec sleep comme recommandé par le TP)
-// sleep(1) est interrompu par SIGCHLD, donc le réveil est quasi-immédiat
+// Attendre un job de premier plan sans attente active ni polling.
+// SIGCHLD est bloqué pendant le test de l'état : s'il arrive entre le test et
+// la mise en sommeil, il reste pendant et sigsuspend() se réveille aussitôt.
 void wait_for_fg_job(job_t *j) {
+    sigset_t mask_chld, prev_mask, wait_mask;
+    sigemptyset(&mask_chld);
+    sigaddset(&mask_chld, SIGCHLD);
+    sigprocmask(SIG_BLOCK, &mask_chld, &prev_mask);
+
+    // Masque d'attente : celui de l'appelant, SIGCHLD débloqué
+    wait_mask = prev_mask;
+    sigdelset(&wait_mask, SIGCHLD);
+
     while (j->state == JOB_RUNNING) {
-        sleep(1);
+        if (evloop_enabled()) {
+            evloop_wait_child();   // Ramassage en contexte normal
+        } else {
+            sigsuspend(&wait_mask);
+            jobqueue_dispatch();   // Places libérées pendant l'attente
+        }
     }
 
     if (j->state == JOB_DONE) {
-        remove_job(j->pgid);
+        last_status = j->status;
+        if (j->timed) {
+            fflush(stdout);
+            print_job_usage(j, stderr, "");
+        }
+        remove_job(j);
     } else if (j->state == JOB_STOPPED) {
+        last_status = 128 + SIGTSTP;
         printf(COL_CYAN "[%d]" COL_RESET " " COL_JAUNE "Stopped" COL_RESET "\t\t" COL_ROSE "%s" COL_RESET "\n", j->id, j->cmdline);
     }
+
+    sigprocmask(SIG_SETMASK, &prev_mask, NULL);
+}
+
+
+// Contexte commun au lancement des étapes d'un pipeline
+typedef struct {
+    struct cmdline *l;
+    int num_cmds;
+    sigset_t child_mask;           // Masque de signaux des fils (SIGCHLD débloqué)
+    int stderr_fd;                 // Sortie d'erreur de toutes les étapes (-1 : celle du shell)
+    const cpu_set_t *cpus;         // Affinité des étapes (NULL : celle du shell)
+    int prio;                      // Priorité baissée des étapes (BGPRIO_OFF : celle du shell)
+} launch_ctx_t;
+
+// Lancement par fork() : le fils branche lui-même ses deux extrémités de pipe
+// (in_fd/out_fd, -1 si aucune) puis fait execv. Tous les autres descripteurs
+// du shell sont O_CLOEXEC : le fils n'a rien d'autre à fermer.
+// Un échec d'exec est remonté au parent par err_fd (pipe CLOEXEC) : le parent
+// lit errno s'il y a eu échec, ou 0 octet si l'exec a réussi.
+static pid_t launch_stage_fork(launch_ctx_t *ctx, int i, const char *path, pid_t pgid,
+                               int in_fd, int out_fd, int err_fd) {
+    struct cmdline *l = ctx->l;
+    pid_t pid = fork();
+
+    if (pid != 0) {
+        return pid;  // Parent (ou échec de fork)
+    }
+
+    // ===== PROCESSUS FILS =====
+
+    // Rétablir les traitants de signaux par défaut
+    signal(SIGINT, SIG_DFL);
+    signal(SIGTSTP, SIG_DFL);
+    signal(SIGCHLD, SIG_DFL);
+
+    // Débloquer SIGCHLD dans le fils (il peut être bloqué en
+    // permanence par la boucle d'événements)
+    sigprocmask(SIG_SETMASK, &ctx->child_mask, NULL);
+
+    // Groupe de processus : tous dans le même groupe (pgid du 1er fils)
+    setpgid(0, pgid);
+
+    if (ctx->cpus != NULL && sched_setaffinity(0, sizeof(cpu_set_t), ctx->cpus) < 0) {
+        perror("pin");
+    }
+    if (ctx->prio != BGPRIO_OFF) {
+        prio_lower_self(ctx->prio);
+    }
+
+    // Redirection d'entrée
+    if (i == 0 && l->in) {
+        int fd = open(l->in, O_RDONLY);
+        if (fd < 0) { perror(l->in); exit(1); }
+        dup2(fd, STDIN_FILENO);
+        close(fd);
+    } else if (in_fd >= 0) {
+        dup2(in_fd, STDIN_FILENO);
+    }
+
+    // Redirection de sortie
+    if (i == ctx->num_cmds - 1 && l->out) {
+        int flags = O_WRONLY | O_CREAT;
+        flags |= l->out_append ? O_APPEND : O_TRUNC;
+        int fd = open(l->out, flags, 0644);
+        if (fd < 0) { perror(l->out); exit(1); }
+        dup2(fd, STDOUT_FILENO);
+        close(fd);
+    } else if (out_fd >= 0) {
+        dup2(out_fd, STDOUT_FILENO);
+    }
+    if (ctx->stderr_fd >= 0) {
+        dup2(ctx->stderr_fd, STDERR_FILENO);
+    }
+
+    // Nettoyer les arguments (enlever espaces parasites)
+    for (int j = 0; l->seq[i][j] != NULL; j++) {
+        l->seq[i][j] = trim_whitespace(l->seq[i][j]);
+    }
+
+    // Exécuter la commande (chemin déjà résolu : pas de parcours de PATH)
+    execv(path, l->seq[i]);
+
+    // Échec : transmettre errno au parent qui affichera l'erreur
+    int err = errno;
+    if (write(err_fd, &err, sizeof(err)) < 0) {
+        command_error(l->seq[i][0]);
+    }
+    _exit(127);
 }
 
+// Lancement par posix_spawn() (clone CLONE_VM|CLONE_VFORK dans la glibc) :
+// pas de copie des tables de pages. Seules deux file actions dup2 branchent
+// l'entrée et la sortie ; le reste est fermé à l'exec (O_CLOEXEC).
+// Retourne le pid, ou -1 avec errno positionné si l'exec a échoué.
+static pid_t launch_stage_spawn(launch_ctx_t *ctx, int i, const char *path, pid_t pgid,
+                                int in_fd, int out_fd) {
+    struct cmdline *l = ctx->l;
+    posix_spawn_file_actions_t fa;
+    posix_spawnattr_t attr;
+    pid_t pid;
+
+    posix_spawn_file_actions_init(&fa);
+    if (in_fd >= 0) {
+        posix_spawn_file_actions_adddup2(&fa, in_fd, STDIN_FILENO);
+    }
+    if (out_fd >= 0) {
+        posix_spawn_file_actions_adddup2(&fa, out_fd, STDOUT_FILENO);
+    }
+    if (ctx->stderr_fd >= 0) {
+        posix_spawn_file_actions_adddup2(&fa, ctx->stderr_fd, STDERR_FILENO);
+    }
+
+    // Groupe de processus, traitants par défaut et masque de signaux du fils
+    sigset_t sigdef;
+    sigemptyset(&sigdef);
+    sigaddset(&sigdef, SIGINT);
+    sigaddset(&sigdef, SIGTSTP);
+    sigaddset(&sigdef, SIGCHLD);
+    short flags = POSIX_SPAWN_SETPGROUP | POSIX_SPAWN_SETSIGDEF | POSIX_SPAWN_SETSIGMASK;
+    posix_spawnattr_init(&attr);
+    // Politique d'ordonnancement posée avant l'exec ; nice et classe d'E/S,
+    // sans attribut, sont baissés juste après le lancement
+    if (ctx->prio != BGPRIO_OFF) {
+        struct sched_param sp = { 0 };
+        flags |= POSIX_SPAWN_SETSCHEDULER;
+        posix_spawnattr_setschedpolicy(&attr, ctx->prio == BGPRIO_IDLE ? SCHED_IDLE : SCHED_BATCH);
+        posix_spawnattr_setschedparam(&attr, &sp);
+    }
+    posix_spawnattr_setflags(&attr, flags);
+    posix_spawnattr_setpgroup(&attr, pgid);
+    posix_spawnattr_setsigdefault(&attr, &sigdef);
+    posix_spawnattr_setsigmask(&attr, &ctx->child_mask);
+
+    // Arguments nettoyés dans un tableau séparé : le parent ne doit pas
+    // remplacer les pointeurs de l->seq, qui seront libérés par readcmd
+    int argc = 0;
+    while (l->seq[i][argc] != NULL) argc++;
+    char *argv[argc + 1];
+    for (int j = 0; j < argc; j++) {
+        argv[j] = trim_whitespace(l->seq[i][j]);
+    }
+    argv[argc] = NULL;
+
+    // posix_spawn n'a pas d'attribut d'affinité : le fils hérite de celle
+    // du shell au clone, posée le temps du lancement
+    cpu_set_t shell_cpus;
+    int pinned = ctx->cpus != NULL &&
+                 sched_getaffinity(0, sizeof(shell_cpus), &shell_cpus) == 0 &&
+                 sched_setaffinity(0, sizeof(cpu_set_t), ctx->cpus) == 0;
+
+    int err = posix_spawn(&pid, path, &fa, &attr, argv, environ);
+
+    if (pinned) sched_setaffinity(0, sizeof(shell_cpus), &shell_cpus);
+    posix_spawnattr_destroy(&attr);
+    posix_spawn_file_actions_destroy(&fa);
 
-// Exécution d'un pipeline (commande simple ou multiple) avec gestion des jobs
-void execute_pipeline(struct cmdline *l) {
+    if (err != 0) {
+        errno = err;
+        return -1;
+    }
+    if (ctx->prio != BGPRIO_OFF) prio_set_pid(pid, ctx->prio);
+    return pid;
+}
+
+// Plafond du noyau pour F_SETPIPE_SZ (lu une seule fois)
+static int pipe_max_size(void) {
+    static int max_size = 0;
+    if (max_size == 0) {
+        max_size = 1024 * 1024;  // Valeur par défaut de Linux
+        FILE *f = fopen("/proc/sys/fs/pipe-max-size", "r");
+        if (f != NULL) {
+            if (fscanf(f, "%d", &max_size) != 1) max_size = 1024 * 1024;
+            fclose(f);
+        }
+    }
+    return max_size;
+}
+
+// Exécution d'un pipeline (commande simple ou multiple) avec gestion des jobs.
+// Les pipes sont créés au fil du lancement : le parent ne garde ouverts que
+// l'extrémité de lecture du pipe précédent et celui de l'étape courante, quel
+// que soit le nombre d'étapes.
+void execute_pipeline(struct cmdline *l, pipeline_opts_t *opts) {
     int num_cmds = count_commands(l->seq);
     int bg = l->bg;
+    job_t *queued = opts->job;     // Job en file lancé par jobqueue.c
+
+    // Capacité des pipes demandée, plafonnée par /proc/sys/fs/pipe-max-size
+    int pipe_size = opts->pipe_size;
+    if (pipe_size > pipe_max_size()) pipe_size = pipe_max_size();
+    int granted_size = 0;          // Plus petite capacité obtenue
 
     // Construire la chaîne de commande pour l'affichage
     char cmdline_str[256];
     build_cmdline_str(l, cmdline_str, sizeof(cmdline_str));
 
-    // Créer les pipes
-    int num_pipes = num_cmds - 1;
-    int pipes[num_pipes > 0 ? num_pipes : 1][2];
-    for (int i = 0; i < num_pipes; i++) {
-        if (pipe(pipes[i]) < 0) {
-            perror("pipe");
-            return;
+    // Arrière-plan au-delà des limites (set maxjobs, maxload, minmem) : en file
+    if (bg && !opts->nowait && queued == NULL && !jobqueue_admit()) {
+        int job_id = jobqueue_enqueue(l, opts, cmdline_str);
+        opts->job = find_job_by_id(job_id);
+        if (job_id > 0 && shell_opts.interactive) {
+            printf(COL_CYAN "[%d]" COL_RESET " " COL_BLEU "Queued" COL_RESET "\n", job_id);
         }
+        return;
     }
 
+    pid_t *pids = malloc(num_cmds * sizeof(pid_t));
+    if (pids == NULL) {
+        perror("malloc");
+        return;
+    }
+
+    // Sans prompt pour vider stdout, la sortie des commandes intégrées
+    // doit partir avant celle des processus lancés
+    fflush(stdout);
+
     // Bloquer SIGCHLD pendant la mise en place des processus et du job
     sigset_t mask_chld, prev_mask;
     sigemptyset(&mask_chld);
     sigaddset(&mask_chld, SIGCHLD);
     sigprocmask(SIG_BLOCK, &mask_chld, &prev_mask);
 
+    launch_ctx_t ctx = { l, num_cmds, prev_mask, opts->err_fd, opts->pinned ? &opts->cpus : NULL,
+                         bg ? opts->prio : BGPRIO_OFF };
+    sigdelset(&ctx.child_mask, SIGCHLD);
+
+    // Le temps réel du job part d'avant le premier lancement
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
     // Créer tous les processus (exécution PARALLÈLE)
-    pid_t pids[num_cmds];
+    int num_procs = 0;
+    int exec_failed = 0;
     pid_t pgid = 0;
+    int prev_read = -1;            // Lecture du pipe de l'étape précédente
 
     for (int i = 0; i < num_cmds; i++) {
-        pids[i] = fork();
+        pid_t pid = -1;
+        int in_fd = prev_read, out_fd = -1;
+        int next_read = -1;
+        int failed = 0;
+        int stage_out;                 // Sortie donnée à l'étape (out_fd ou celle de opts)
+
+        // Pipe vers l'étape suivante
+        if (i < num_cmds - 1) {
+            int p[2];
+            if (pipe2(p, O_CLOEXEC) < 0) {
+                perror("pipe");
+                if (prev_read >= 0) close(prev_read);
+                break;
+            }
+            out_fd = p[1];
+            next_read = p[0];
 
-        if (pids[i] < 0) {
-            perror("fork");
-            sigprocmask(SIG_SETMASK, &prev_mask, NULL);
-            return;
+            int got = pipe_size > 0 ? fcntl(p[1], F_SETPIPE_SZ, pipe_size) : -1;
+            if (got < 0) got = fcntl(p[1], F_GETPIPE_SZ);
+            if (got > 0 && (granted_size == 0 || got < granted_size)) granted_size = got;
         }
 
-        if (pids[i] == 0) {
-            // ===== PROCESSUS FILS =====
-
-            // Rétablir les traitants de signaux par défaut
-            signal(SIGINT, SIG_DFL);
-            signal(SIGTSTP, SIG_DFL);
-            signal(SIGCHLD, SIG_DFL);
-
-            // Débloquer SIGCHLD dans le fils
-            sigprocmask(SIG_SETMASK, &prev_mask, NULL);
-
-            // Groupe de processus : tous dans le même groupe (pgid du 1er fils)
-            setpgid(0, pgid);
+        stage_out = (i == num_cmds - 1 && opts->out_fd >= 0) ? opts->out_fd : out_fd;
 
-            // Redirection d'entrée
+        // Résolution dans PATH par le parent, via le cache de "hash"
+        const char *path = path_lookup(trim_whitespace(l->seq[i][0]));
+        if (path == NULL) {
+            failed = ENOENT;
+        } else if (shell_opts.spawn_mode == SPAWN_POSIX) {
+            // Redirections de fichiers ouvertes par le parent
+            int fd_in = -1, fd_out = -1;
             if (i == 0 && l->in) {
-                int fd = open(l->in, O_RDONLY);
-                if (fd < 0) { perror(l->in); exit(1); }
-                dup2(fd, STDIN_FILENO);
-                close(fd);
-            } else if (i > 0) {
-                dup2(pipes[i-1][0], STDIN_FILENO);
+                fd_in = open(l->in, O_RDONLY | O_CLOEXEC);
+                if (fd_in < 0) perror(l->in);
             }
-
-            // Redirection de sortie
             if (i == num_cmds - 1 && l->out) {
-                int flags = O_WRONLY | O_CREAT;
+                int flags = O_WRONLY | O_CREAT | O_CLOEXEC;
                 flags |= l->out_append ? O_APPEND : O_TRUNC;
-                int fd = open(l->out, flags, 0644);
-                if (fd < 0) { perror(l->out); exit(1); }
-                dup2(fd, STDOUT_FILENO);
-                close(fd);
-            } else if (i < num_cmds - 1) {
-                dup2(pipes[i][1], STDOUT_FILENO);
+                fd_out = open(l->out, flags, 0644);
+                if (fd_out < 0) perror(l->out);
             }
-
-            // Fermer TOUS les pipes dans le fils
-            for (int j = 0; j < num_pipes; j++) {
-                close(pipes[j][0]);
-                close(pipes[j][1]);
+            if ((i == 0 && l->in && fd_in < 0) || (i == num_cmds - 1 && l->out && fd_out < 0)) {
+                pid = -1;  // Erreur déjà affichée
+            } else {
+                pid = launch_stage_spawn(&ctx, i, path, pgid,
+                                         fd_in >= 0 ? fd_in : in_fd,
+                                         fd_out >= 0 ? fd_out : stage_out);
+                if (pid < 0) failed = errno;
             }
-
-            // Nettoyer les arguments (enlever espaces parasites)
-            for (int j = 0; l->seq[i][j] != NULL; j++) {
-                l->seq[i][j] = trim_whitespace(l->seq[i][j]);
+            if (fd_in >= 0) close(fd_in);
+            if (fd_out >= 0) close(fd_out);
+        } else {
+            int err_pipe[2];
+            if (pipe2(err_pipe, O_CLOEXEC) < 0) {
+                perror("pipe");
+                pid = -1;
+            } else {
+                pid = launch_stage_fork(&ctx, i, path, pgid, in_fd, stage_out, err_pipe[1]);
+                close(err_pipe[1]);
+                if (pid < 0) {
+                    perror("fork");
+                } else if (read(err_pipe[0], &failed, sizeof(failed)) != sizeof(failed)) {
+                    failed = 0;  // 0 octet : l'exec a réussi
+                }
+                close(err_pipe[0]);
             }
+        }
 
-            // Exécuter la commande
-            execvp(l->seq[i][0], l->seq[i]);
+        // Le parent n'a plus besoin des extrémités données à cette étape
+        if (in_fd >= 0) close(in_fd);
+        if (out_fd >= 0) close(out_fd);
+        prev_read = next_read;
 
+        // Échec d'exec affiché par le parent, dans l'ordre du pipeline
+        if (failed != 0) {
             command_error(l->seq[i][0]);
-            exit(1);
+            exec_failed = 1;
+        }
+        if (path == NULL || pid < 0) {
+            continue;
         }
 
         // ===== PROCESSUS PARENT =====
-        if (i == 0) pgid = pids[0];
-        setpgid(pids[i], pgid);  // Aussi dans le parent pour éviter la race condition
+        if (pgid == 0) pgid = pid;
+        setpgid(pid, pgid);  // Aussi dans le parent pour éviter la race condition
+        pids[num_procs++] = pid;
     }
 
-    // Fermer tous les pipes dans le parent
-    for (int i = 0; i < num_pipes; i++) {
-        close(pipes[i][0]);
-        close(pipes[i][1]);
+    // Aucun processus lancé : pas de job. Un job en file se termine là,
+    // son échec est signalé comme celui de tout job en arrière-plan.
+    opts->job = NULL;
+    if (num_procs == 0) {
+        last_status = exec_failed ? 127 : 1;
+        if (queued != NULL) {
+            queued->status = last_status;
+            queued->state = JOB_DONE;
+            queued->bg = bg;
+            if (!bg) remove_job(queued);
+        }
+        sigprocmask(SIG_SETMASK, &prev_mask, NULL);
+        free(pids);
+        return;
     }
 
-    // Ajouter le job à la table
-    int job_id = add_job(pgid, pids, num_cmds, JOB_RUNNING, bg, cmdline_str);
-
-    // Débloquer SIGCHLD
-    sigprocmask(SIG_SETMASK, &prev_mask, NULL);
-
-    if (bg) {
+    // Ajouter le job à la table (ou donner ses processus au job en file)
+    int job_id;
+    if (queued != NULL) {
+        job_id = attach_job_procs(queued, pgid, pids, num_procs, bg) == 0 ? queued->id : -1;
+    } else {
+        job_id = add_job(pgid, pids, num_procs, JOB_RUNNING, bg, cmdline_str);
+    }
+    free(pids);
+    job_t *job = find_job_by_pid(pgid);
+    if (job != NULL) {
+        job->pipe_size = granted_size;
+        job->start = start;
+        job->timed = opts->timed;
+        job->prio = opts->prio;
+    }
+    opts->job = job;
+
+    if (opts->nowait) {
+        // Lancé pour le compte de l'appelant (parallel), qui attend lui-même
+        sigprocmask(SIG_SETMASK, &prev_mask, NULL);
+    } else if (bg) {
+        // Débloquer SIGCHLD
+        sigprocmask(SIG_SETMASK, &prev_mask, NULL);
         // Arrière-plan : afficher le numéro de job et le pgid
-        printf(COL_CYAN "[%d]" COL_RESET " %d\n", job_id, pgid);
+        if (shell_opts.interactive) {
+            printf(COL_CYAN "[%d]" COL_RESET " %d\n", job_id, pgid);
+        }
     } else {
-        // Premier plan : attendre la fin du job
+        // Premier plan : attendre la fin du job, SIGCHLD encore bloqué pour
+        // qu'aucune terminaison ne soit perdue avant sigsuspend()
         job_t *j = find_job_by_pid(pgid);
         if (j != NULL) {
             wait_for_fg_job(j);
         }
+        sigprocmask(SIG_SETMASK, &prev_mask, NULL);
     }
 }
 
+// Préfixes de pipeline en tête de la première commande :
+//   pipesize TAILLE   capacité des pipes de ce pipeline
+//   time              temps et ressources de chaque étape, affichés à la fin
+//   pin CPUS          processeurs de toutes les étapes ("pin CPUS %n" est la
+//                     commande intégrée, pour un job déjà lancé)
+//   prio POLITIQUE    priorité du job quand il est en arrière-plan (de même,
+//                     "prio POLITIQUE %n" est la commande intégrée)
+// Retourne le nombre de mots consommés, ou -1 en cas d'erreur.
+static int parse_pipeline_prefixes(char **cmd, pipeline_opts_t *opts) {
+    int k = 0;
+    while (cmd[k] != NULL) {
+        if (strcmp(cmd[k], "pipesize") == 0) {
+            long size = cmd[k + 1] != NULL ? parse_size(cmd[k + 1]) : -1;
+            if (size < 0 || size > INT_MAX || cmd[k + 2] == NULL) {
+                fprintf(stderr, COL_ROUGE "usage: pipesize TAILLE commande [| commande...]" COL_RESET "\n");
+                return -1;
+            }
+            opts->pipe_size = (int)size;
+            k += 2;
+        } else if (strcmp(cmd[k], "time") == 0) {
+            if (cmd[k + 1] == NULL) {
+                fprintf(stderr, COL_ROUGE "usage: time commande [| commande...]" COL_RESET "\n");
+                return -1;
+            }
+            opts->timed = 1;
+            k++;
+        } else if (strcmp(cmd[k], "pin") == 0 && cmd[k + 1] != NULL &&
+                   cmd[k + 2] != NULL && cmd[k + 2][0] != '%') {
+            cpu_set_t allowed, both;
+            if (parse_cpu_list(cmd[k + 1], &opts->cpus) < 0) {
+                fprintf(stderr, COL_ROUGE "pin: liste de processeurs invalide: %s" COL_RESET "\n", cmd[k + 1]);
+                return -1;
+            }
+            // Au moins un processeur utilisable, sinon le lancement échouerait
+            if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0) {
+                CPU_AND(&both, &allowed, &opts->cpus);
+                if (CPU_COUNT(&both) == 0) {
+                    fprintf(stderr, COL_ROUGE "pin: aucun de ces processeurs n'est disponible: %s" COL_RESET "\n", cmd[k + 1]);
+                    return -1;
+                }
+            }
+            opts->pinned = 1;
+            k += 2;
+        } else if (strcmp(cmd[k], "prio") == 0 && cmd[k + 1] != NULL &&
+                   cmd[k + 2] != NULL && cmd[k + 2][0] != '%') {
+            int prio = bgprio_parse(cmd[k + 1]);
+            if (prio < 0) {
+                fprintf(stderr, COL_ROUGE "prio: politique inconnue: %s (off, batch ou idle)" COL_RESET "\n", cmd[k + 1]);
+                return -1;
+            }
+            opts->prio = prio;
+            k += 2;
+        } else {
+            break;
+        }
+    }
+    return k;
+}
+
 void execute_cmdline(struct cmdline *l) {
     // Vérifier si c'est une commande vide
     if (l->seq == NULL || l->seq[0] == NULL || l->seq[0][0] == NULL) {
         return;
     }
 
-    // Vérifier si c'est une commande intégrée (seulement sans pipe et sans redirection)
-    if (count_commands(l->seq) == 1 && l->in == NULL && l->out == NULL) {
-        int result = try_execute_builtin(l->seq[0]);
-        if (result >= 0) {
-            return;
+    // Options du pipeline : celles du shell, modifiées par les préfixes.
+    // Les mots consommés sont sautés le temps de l'exécution (seq[0] reste
+    // la propriété de readcmd et doit être restauré pour être libéré).
+    pipeline_opts_t opts = PIPELINE_OPTS_DEFAULT;
+    char **first = l->seq[0];
+    int skip = parse_pipeline_prefixes(first, &opts);
+    if (skip < 0) {
+        last_status = 2;
+        return;
+    }
+    l->seq[0] = first + skip;
+
+    // Commande intégrée : seulement sans pipe. Celles qui existent aussi en
+    // programme externe passent par execute_pipeline en arrière-plan.
+    builtin_cmd_t *b = NULL;
+    if (count_commands(l->seq) == 1) {
+        b = find_builtin(l->seq[0][0]);
+    }
+    if (b != NULL && !(l->bg && b->has_external)) {
+        // Commande intégrée chronométrée : consommation du shell lui-même
+        struct timespec t0, t1;
+        struct rusage ru0, ru1;
+        if (opts.timed) {
+            clock_gettime(CLOCK_MONOTONIC, &t0);
+            getrusage(RUSAGE_SELF, &ru0);
         }
+        last_status = run_builtin_redirected(b, l->seq[0], l->in, l->out, l->out_append);
+        if (opts.timed) {
+            clock_gettime(CLOCK_MONOTONIC, &t1);
+            getrusage(RUSAGE_SELF, &ru1);
+            timersub(&ru1.ru_utime, &ru0.ru_utime, &ru1.ru_utime);
+            timersub(&ru1.ru_stime, &ru0.ru_stime, &ru1.ru_stime);
+            ru1.ru_nvcsw -= ru0.ru_nvcsw;
+            ru1.ru_nivcsw -= ru0.ru_nivcsw;
+            fflush(stdout);
+            print_usage_line(stderr, timespec_diff(t0, t1), &ru1);
+        }
+    } else {
+        // Sinon, exécuter la commande ou le pipeline
+        execute_pipeline(l, &opts);
     }
 
-    // Sinon, exécuter la commande ou le pipeline
-    execute_pipeline(l);
+    l->seq[0] = first;
 }
-
-
-
-